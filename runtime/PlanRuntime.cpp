@@ -0,0 +1,371 @@
+#include "pgoe.h"
+
+#include <cxxabi.h>	// abi::__cxa_demangle()
+#include <dlfcn.h>
+#include <elf.h>
+#include <link.h>	// dl_iterate_phdr()
+#include <time.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define NO_INSTRUMENT __attribute__((no_instrument_function))
+
+namespace {
+
+/*
+ * RN: CHD (compress, hash, displace) minimal perfect hashing. The keys are hashed into buckets,
+ * the largest bucket first gets the smallest displacement that puts all of its keys into free slots.
+ * A lookup is one hash for the bucket, one for the slot and a compare with the key in that slot.
+ * Everything the probes touch is a plain global, so nothing depends on the order of static initialization.
+ */
+const int maxDepth = 1024;
+const uint32_t maxDisplacement = 1 << 16;
+const int attemptsPerTableSize = 8;
+
+uint64_t seed = 0;
+uint32_t numberOfBuckets = 0;
+uint32_t tableSize = 0;
+uint32_t* displacements = nullptr;
+uintptr_t* keys = nullptr;	// per slot
+char** names = nullptr;	// per slot
+uint64_t* calls = nullptr;	// per slot
+uint64_t* nanos = nullptr;	// per slot
+int numberOfUnresolved = 0;	// of the last plan
+
+struct Frame {
+	uint32_t slot;
+	uint64_t start;
+};
+
+thread_local Frame stack[maxDepth];
+thread_local int depth = 0;
+
+NO_INSTRUMENT inline uint64_t hash(uintptr_t key, uint64_t seed) {
+	uint64_t h = (key ^ seed) * 0x9E3779B97F4A7C15ULL;
+	h ^= h >> 29;
+	h *= 0xBF58476D1CE4E5B9ULL;
+	return h ^ (h >> 32);
+}
+
+/** maps the upper bits of h to [0, n) without a division */
+NO_INSTRUMENT inline uint32_t reduce(uint64_t h, uint32_t n) {
+	return (uint32_t) (((h >> 32) * (uint64_t) n) >> 32);
+}
+
+NO_INSTRUMENT inline uint64_t displace(uint64_t seed, uint32_t displacement) {
+	return seed ^ (displacement * 0xC2B2AE3D27D4EB4FULL);
+}
+
+/** -1 if the function is not in the plan */
+NO_INSTRUMENT inline int64_t lookup(void* function) {
+	if (tableSize == 0) {
+		return -1;
+	}
+	uintptr_t key = (uintptr_t) function;
+	uint32_t bucket = reduce(hash(key, seed), numberOfBuckets);
+	uint32_t slot = reduce(hash(key, displace(seed, displacements[bucket])), tableSize);
+	return (keys[slot] == key) ? (int64_t) slot : -1;
+}
+
+NO_INSTRUMENT inline uint64_t now() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+NO_INSTRUMENT void clearPlan() {
+	for (uint32_t slot = 0; names != nullptr && slot < tableSize; slot++) {
+		free(names[slot]);
+	}
+	delete[] displacements;
+	delete[] keys;
+	delete[] names;
+	delete[] calls;
+	delete[] nanos;
+	displacements = nullptr;
+	keys = nullptr;
+	names = nullptr;
+	calls = nullptr;
+	nanos = nullptr;
+	tableSize = 0;
+	numberOfBuckets = 0;
+}
+
+NO_INSTRUMENT int findExecutableBase(struct dl_phdr_info* info, size_t size, void* data) {
+	*(uintptr_t*) data = info->dlpi_addr;
+	return 1;	// the executable is always the first object
+}
+
+/**
+ * RN: the plans have the names of the profile, i.e., demangled names like "foo()" unless the
+ * profile was read with --mangled. dlsym only knows mangled names of exported symbols, so the
+ * functions of the executable are taken from its symbol table (.symtab, .dynsym if stripped) and
+ * are found by their mangled & their demangled name, static functions and builds without -rdynamic included.
+ */
+NO_INSTRUMENT std::unordered_map<std::string, uintptr_t> readExecutableFunctions() {
+	std::unordered_map<std::string, uintptr_t> functions;
+
+	std::ifstream file("/proc/self/exe", std::ios::binary);
+	std::vector<char> image((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (image.size() < sizeof(ElfW(Ehdr)) || memcmp(image.data(), ELFMAG, SELFMAG) != 0) {
+		return functions;
+	}
+	auto header = (const ElfW(Ehdr)*) image.data();
+	if (header->e_shoff == 0 || header->e_shoff + header->e_shnum * sizeof(ElfW(Shdr)) > image.size()) {
+		return functions;
+	}
+	auto sections = (const ElfW(Shdr)*) (image.data() + header->e_shoff);
+
+	const ElfW(Shdr)* symbolTable = nullptr;
+	for (int i = 0; i < header->e_shnum; i++) {
+		if (sections[i].sh_type == SHT_SYMTAB
+				|| (sections[i].sh_type == SHT_DYNSYM && symbolTable == nullptr)) {
+			symbolTable = &sections[i];
+		}
+	}
+	if (symbolTable == nullptr || symbolTable->sh_link >= header->e_shnum
+			|| symbolTable->sh_offset + symbolTable->sh_size > image.size()) {
+		return functions;
+	}
+	const ElfW(Shdr)& stringTable = sections[symbolTable->sh_link];
+	if (stringTable.sh_offset + stringTable.sh_size > image.size()) {
+		return functions;
+	}
+
+	// position independent executables are loaded at an offset, for the others the base is 0
+	uintptr_t base = 0;
+	dl_iterate_phdr(findExecutableBase, &base);
+
+	auto symbols = (const ElfW(Sym)*) (image.data() + symbolTable->sh_offset);
+	size_t numberOfSymbols = symbolTable->sh_size / sizeof(ElfW(Sym));
+	for (size_t i = 0; i < numberOfSymbols; i++) {
+		const ElfW(Sym)& symbol = symbols[i];
+		if (ELF64_ST_TYPE(symbol.st_info) != STT_FUNC || symbol.st_shndx == SHN_UNDEF || symbol.st_value == 0
+				|| symbol.st_name >= stringTable.sh_size) {
+			continue;
+		}
+		const char* name = image.data() + stringTable.sh_offset + symbol.st_name;
+		uintptr_t address = base + symbol.st_value;
+		functions.insert(std::make_pair(name, address));
+
+		int status = 0;
+		char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+		if (status == 0 && demangled != nullptr) {
+			functions.insert(std::make_pair(demangled, address));
+		}
+		free(demangled);
+	}
+	return functions;
+}
+
+/** false if no displacement fits for some bucket */
+NO_INSTRUMENT bool buildTable(const std::vector<uintptr_t>& addresses, uint64_t attemptSeed, uint32_t size,
+		std::vector<uint32_t>& bucketDisplacements, std::vector<int>& slotOfKey) {
+
+	uint32_t bucketCount = std::max<uint32_t>(1, addresses.size() / 4);
+	std::vector<std::vector<int> > buckets(bucketCount);
+	for (size_t i = 0; i < addresses.size(); i++) {
+		buckets[reduce(hash(addresses[i], attemptSeed), bucketCount)].push_back(i);
+	}
+	std::vector<uint32_t> order(bucketCount);
+	for (uint32_t i = 0; i < bucketCount; i++) {
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(),
+			[&buckets](uint32_t lhs, uint32_t rhs) { return buckets[lhs].size() > buckets[rhs].size(); });
+
+	bucketDisplacements.assign(bucketCount, 0);
+	slotOfKey.assign(addresses.size(), -1);
+	std::vector<bool> occupied(size, false);
+	std::vector<uint32_t> slots;
+
+	for (uint32_t bucket : order) {
+		if (buckets[bucket].empty()) {
+			break;
+		}
+		bool placed = false;
+		for (uint32_t displacement = 0; displacement < maxDisplacement && !placed; displacement++) {
+			slots.clear();
+			placed = true;
+			for (int key : buckets[bucket]) {
+				uint32_t slot = reduce(hash(addresses[key], displace(attemptSeed, displacement)), size);
+				if (occupied[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+					placed = false;
+					break;
+				}
+				slots.push_back(slot);
+			}
+			if (placed) {
+				bucketDisplacements[bucket] = displacement;
+				for (size_t i = 0; i < slots.size(); i++) {
+					occupied[slots[i]] = true;
+					slotOfKey[buckets[bucket][i]] = slots[i];
+				}
+			}
+		}
+		if (!placed) {
+			return false;
+		}
+	}
+	numberOfBuckets = bucketCount;
+	return true;
+}
+
+}
+
+extern "C" {
+
+NO_INSTRUMENT int pgoe_load_plan(const char* path) {
+	std::ifstream plan(path);
+	if (!plan.is_open()) {
+		fprintf(stderr, "pgoe: can not open plan %s\n", path);
+		return -1;
+	}
+
+	auto executableFunctions = readExecutableFunctions();
+
+	std::vector<std::pair<uintptr_t, std::string> > functions;
+	numberOfUnresolved = 0;
+	int numberOfNames = 0;
+	std::string name;
+	while (std::getline(plan, name)) {
+		if (name.empty() || name[0] == '#') {
+			continue;
+		}
+		numberOfNames++;
+		auto it = executableFunctions.find(name);
+		// functions of shared libraries only by their mangled name
+		void* address = (it != executableFunctions.end()) ? (void*) it->second : dlsym(RTLD_DEFAULT, name.c_str());
+		if (address == nullptr) {
+			fprintf(stderr, "pgoe: %s of %s not found\n", name.c_str(), path);
+			numberOfUnresolved++;
+			continue;
+		}
+		functions.push_back(std::make_pair((uintptr_t) address, name));
+	}
+	if (numberOfUnresolved > 0) {
+		fprintf(stderr, "pgoe: %d of %d functions of %s not found\n", numberOfUnresolved, numberOfNames, path);
+	}
+
+	// aliases resolve to the same address
+	std::sort(functions.begin(), functions.end());
+	functions.erase(std::unique(functions.begin(), functions.end(),
+			[](const std::pair<uintptr_t, std::string>& lhs, const std::pair<uintptr_t, std::string>& rhs) {
+				return lhs.first == rhs.first;
+			}), functions.end());
+
+	clearPlan();
+	if (functions.empty()) {
+		return 0;
+	}
+
+	std::vector<uintptr_t> addresses;
+	for (auto& function : functions) {
+		addresses.push_back(function.first);
+	}
+
+	// minimal first, a slightly larger table if that does not work out
+	std::vector<uint32_t> bucketDisplacements;
+	std::vector<int> slotOfKey;
+	uint32_t size = addresses.size();
+	for (int attempt = 0; ; attempt++) {
+		seed = hash(attempt + 1, 0x2545F4914F6CDD1DULL);
+		if (buildTable(addresses, seed, size, bucketDisplacements, slotOfKey)) {
+			break;
+		}
+		if ((attempt + 1) % attemptsPerTableSize == 0) {
+			size += size / 8 + 1;
+		}
+	}
+
+	displacements = new uint32_t[numberOfBuckets];
+	std::copy(bucketDisplacements.begin(), bucketDisplacements.end(), displacements);
+	keys = new uintptr_t[size]();
+	names = new char*[size]();
+	calls = new uint64_t[size]();
+	nanos = new uint64_t[size]();
+	for (size_t i = 0; i < functions.size(); i++) {
+		keys[slotOfKey[i]] = functions[i].first;
+		names[slotOfKey[i]] = strdup(functions[i].second.c_str());
+	}
+	tableSize = size;	// last, so the probes see a complete table
+
+	return functions.size();
+}
+
+NO_INSTRUMENT int pgoe_number_of_unresolved() {
+	return numberOfUnresolved;
+}
+
+NO_INSTRUMENT int pgoe_write_profile(const char* path) {
+	FILE* out = fopen(path, "w");
+	if (out == nullptr) {
+		fprintf(stderr, "pgoe: can not write profile %s\n", path);
+		return 1;
+	}
+	for (uint32_t slot = 0; slot < tableSize; slot++) {
+		if (names[slot] != nullptr) {
+			fprintf(out, "%s\t%llu\t%llu\n", names[slot],
+					(unsigned long long) __atomic_load_n(&calls[slot], __ATOMIC_RELAXED),
+					(unsigned long long) __atomic_load_n(&nanos[slot], __ATOMIC_RELAXED));
+		}
+	}
+	fclose(out);
+	return 0;
+}
+
+NO_INSTRUMENT void __cyg_profile_func_enter(void* function, void* callSite) {
+	int64_t slot = lookup(function);
+	if (slot < 0) {
+		return;
+	}
+	if (depth < maxDepth) {
+		stack[depth].slot = slot;
+		stack[depth].start = now();
+	}
+	depth++;
+}
+
+NO_INSTRUMENT void __cyg_profile_func_exit(void* function, void* callSite) {
+	int64_t slot = lookup(function);
+	if (slot < 0 || depth == 0) {
+		return;
+	}
+	depth--;
+	if (depth < maxDepth) {
+		__atomic_fetch_add(&calls[slot], 1, __ATOMIC_RELAXED);
+		__atomic_fetch_add(&nanos[slot], now() - stack[depth].start, __ATOMIC_RELAXED);
+	}
+}
+
+}
+
+NO_INSTRUMENT __attribute__((constructor)) static void loadPlanOnStartup() {
+	const char* plan = getenv("PGOE_PLAN");
+	if (plan == nullptr) {
+		return;
+	}
+	// RN: a measurement with a part of the plan is worse than none, it looks complete
+	if (pgoe_load_plan(plan) < 0 || (numberOfUnresolved > 0 && getenv("PGOE_ALLOW_UNRESOLVED") == nullptr)) {
+		fprintf(stderr, "pgoe: the plan %s can not be measured (set PGOE_ALLOW_UNRESOLVED to measure the rest)\n",
+				plan);
+		exit(1);
+	}
+}
+
+NO_INSTRUMENT __attribute__((destructor)) static void writeProfileAtExit() {
+	if (tableSize == 0) {
+		return;
+	}
+	const char* output = getenv("PGOE_OUTPUT");
+	pgoe_write_profile(output != nullptr ? output : "pgoe-profile.txt");
+}
@@ -0,0 +1,101 @@
+#include "pgoe.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+/*
+ * Micro-benchmark of the probe cost. This file is compiled with -finstrument-functions and -rdynamic,
+ * the runtime without. The same empty function is called once with a plan that selects it, once
+ * with a plan that does not and once uninstrumented, the differences are the probe costs.
+ */
+
+#define NO_INSTRUMENT __attribute__((no_instrument_function))
+
+extern "C" {
+
+__attribute__((noinline)) int pgoeBenchSelected(int i) {
+	asm volatile("" : "+r"(i));
+	return i + 1;
+}
+
+__attribute__((noinline)) int pgoeBenchFiltered(int i) {
+	asm volatile("" : "+r"(i));
+	return i + 1;
+}
+
+NO_INSTRUMENT __attribute__((noinline)) int pgoeBenchBaseline(int i) {
+	asm volatile("" : "+r"(i));
+	return i + 1;
+}
+
+}
+
+namespace {
+
+const int iterations = 10000000;
+
+/** nanoseconds per call */
+template<typename Function>
+NO_INSTRUMENT double measure(Function function) {
+	int sum = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++) {
+		sum += function(i);
+	}
+	auto end = std::chrono::steady_clock::now();
+	if (sum == 42) {
+		printf(" ");	// keeps the calls alive
+	}
+	return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+NO_INSTRUMENT bool writePlan(const char* path, const char* content) {
+	FILE* plan = fopen(path, "w");
+	if (plan == nullptr) {
+		return false;
+	}
+	fputs(content, plan);
+	fclose(plan);
+	return true;
+}
+
+}
+
+NO_INSTRUMENT int main(int argc, char** argv) {
+	char path[] = "/tmp/pgoe-plan-XXXXXX";
+	int fd = mkstemp(path);
+	if (fd < 0) {
+		fprintf(stderr, "Can not create a temporary plan\n");
+		return 1;
+	}
+	close(fd);
+
+	double baseline = measure(pgoeBenchBaseline);
+
+	// an empty plan, the probes of all functions return immediately
+	writePlan(path, "# empty\n");
+	pgoe_load_plan(path);
+	double unfilteredEmpty = measure(pgoeBenchFiltered);
+
+	if (!writePlan(path, "pgoeBenchSelected\n") || pgoe_load_plan(path) != 1) {
+		fprintf(stderr, "Can not resolve pgoeBenchSelected (linked with -rdynamic?)\n");
+		unlink(path);
+		return 1;
+	}
+	double filtered = measure(pgoeBenchFiltered);
+	double selected = measure(pgoeBenchSelected);
+
+	// no profile at exit
+	writePlan(path, "# empty\n");
+	pgoe_load_plan(path);
+	unlink(path);
+
+	printf("%d calls each\n", iterations);
+	printf("uninstrumented:                 %6.2f ns/call\n", baseline);
+	printf("filtered (empty plan):          %6.2f ns/call (+%.2f)\n", unfilteredEmpty, unfilteredEmpty - baseline);
+	printf("filtered (perfect hash miss):   %6.2f ns/call (+%.2f)\n", filtered, filtered - baseline);
+	printf("selected (measured):            %6.2f ns/call (+%.2f)\n", selected, selected - baseline);
+	return 0;
+}
@@ -0,0 +1,37 @@
+#ifndef PGOE_H_
+#define PGOE_H_
+
+/**
+ * Runtime for -finstrument-functions that only measures the functions of a plan.
+ * On startup the plan in $PGOE_PLAN (a plain plan, one function name per line, see --emit plain)
+ * is resolved to function addresses. The functions of the executable are found by their mangled or
+ * demangled name in its symbol table, those of shared libraries by their mangled name with dlsym.
+ * The application exits if a function of the plan is not found, unless $PGOE_ALLOW_UNRESOLVED is set.
+ * The addresses go into a minimal perfect hash table: the probe of a function that is not in the
+ * plan returns after one hash lookup. For the functions of the plan the calls and the inclusive
+ * time are measured and written to $PGOE_OUTPUT (default pgoe-profile.txt) at exit:
+ *   name	calls	nanos
+ *
+ * RN: this file must not be compiled with -finstrument-functions, the probes would call themselves.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** replaces the current plan, not thread safe. Returns the number of resolved functions or -1. */
+int pgoe_load_plan(const char* path);
+/** the functions of the last plan that were not found, they are reported on stderr */
+int pgoe_number_of_unresolved(void);
+
+/** returns 0 on success */
+int pgoe_write_profile(const char* path);
+
+void __cyg_profile_func_enter(void* function, void* callSite);
+void __cyg_profile_func_exit(void* function, void* callSite);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
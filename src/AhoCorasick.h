@@ -0,0 +1,97 @@
+#ifndef AHOCORASICK_H_
+#define AHOCORASICK_H_
+
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Finds all occurrences of a set of keywords in a text in one pass over the text.
+ * Keywords are added first, build() computes the failure links, then texts are searched.
+ */
+class AhoCorasick {
+public:
+	AhoCorasick() : states(1) {}
+
+	/** returns the id of the keyword, ids are consecutive from 0 */
+	int add(const std::string& keyword) {
+		int state = 0;
+		for (unsigned char c : keyword) {
+			auto next = states[state].next.find(c);
+			if (next == states[state].next.end()) {
+				states[state].next[c] = states.size();
+				state = states.size();
+				states.push_back(State());
+			} else {
+				state = next->second;
+			}
+		}
+		states[state].keywords.push_back(numberOfKeywords);
+		return numberOfKeywords++;
+	}
+
+	/** breadth first, so the failure link of a state is done before its successors */
+	void build() {
+		std::queue<int> workQueue;
+		for (auto& transition : states[0].next) {
+			states[transition.second].fail = 0;
+			workQueue.push(transition.second);
+		}
+
+		while (!workQueue.empty()) {
+			int state = workQueue.front();
+			workQueue.pop();
+
+			for (auto& transition : states[state].next) {
+				int fail = states[state].fail;
+				while (fail > 0 && states[fail].next.count(transition.first) == 0) {
+					fail = states[fail].fail;
+				}
+				auto failNext = states[fail].next.find(transition.first);
+				int child = transition.second;
+				states[child].fail = (failNext != states[fail].next.end() && failNext->second != child)
+						? failNext->second : 0;
+				// the nearest state on the failure chain that ends a keyword
+				int failState = states[child].fail;
+				states[child].output = states[failState].keywords.empty() ? states[failState].output : failState;
+				workQueue.push(child);
+			}
+		}
+	}
+
+	/** calls found(keywordId) for every occurrence of a keyword in text */
+	template<typename Callback>
+	void search(const std::string& text, Callback found) const {
+		int state = 0;
+		for (unsigned char c : text) {
+			auto next = states[state].next.find(c);
+			while (state > 0 && next == states[state].next.end()) {
+				state = states[state].fail;
+				next = states[state].next.find(c);
+			}
+			state = (next != states[state].next.end()) ? next->second : 0;
+
+			for (int match = state; match > 0; match = states[match].output) {
+				for (int keyword : states[match].keywords) {
+					found(keyword);
+				}
+			}
+		}
+	}
+
+	int size() const { return numberOfKeywords; }
+
+private:
+	struct State {
+		std::unordered_map<unsigned char, int> next;
+		int fail = 0;
+		int output = 0;	// 0 (the root) ends the output chain
+		std::vector<int> keywords;
+	};
+
+	std::vector<State> states;
+	int numberOfKeywords = 0;
+};
+
+#endif
@@ -0,0 +1,231 @@
+#include "BallLarusEstimatorPhase.h"
+
+#include <algorithm>
+#include <climits>
+
+BallLarusEstimatorPhase::BallLarusEstimatorPhase() :
+		EstimatorPhase("BallLarus"),
+		numberOfSccs(0),
+		entryNode(0),
+		exitNode(0),
+		numberOfPaths(0),
+		unnumberedCalls(0),
+		numberOfChords(0),
+		overflow(false) {
+}
+
+void BallLarusEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
+
+	IndexedCallgraph indexedGraph(*graph);
+
+	buildDag(indexedGraph);
+	numberPaths();
+	placeIncrements();
+	writeIncrements(indexedGraph);
+}
+
+/** the out edges of an SCC start with its EXIT edge, so that edge gets the value 0 */
+void BallLarusEstimatorPhase::buildDag(const IndexedCallgraph& indexedGraph) {
+
+	numberOfSccs = indexedGraph.getNumberOfSccs();
+	entryNode = numberOfSccs;
+	exitNode = numberOfSccs + 1;
+	outEdges.assign(numberOfSccs + 2, std::vector<int>());
+
+	std::vector<unsigned long long> enteringCalls(numberOfSccs, 0);
+	std::vector<bool> hasCaller(numberOfSccs, false);
+	std::vector<int> edgeTo(numberOfSccs, -1);
+
+	for (int scc = 0; scc < numberOfSccs; scc++) {
+		outEdges[scc].push_back(edges.size());
+		edges.push_back(DagEdge{scc, exitNode, 0, 0, 0, false});
+
+		for (int member : indexedGraph.getSccMembers(scc)) {
+			auto memberNode = indexedGraph.getNode(member);
+			for (int child : indexedGraph.getChildren(member)) {
+				unsigned long long calls = indexedGraph.getNode(child)->getNumberOfCalls(memberNode);
+				int childScc = indexedGraph.getScc(child);
+
+				if (childScc == scc) {
+					unnumberedCalls += calls;
+					continue;
+				}
+				if (edgeTo[childScc] < 0 || edges[edgeTo[childScc]].from != scc) {
+					edgeTo[childScc] = edges.size();
+					outEdges[scc].push_back(edges.size());
+					edges.push_back(DagEdge{scc, childScc, 0, 0, 0, false});
+				}
+				edges[edgeTo[childScc]].calls += calls;
+				enteringCalls[childScc] += calls;
+				hasCaller[childScc] = true;
+			}
+		}
+	}
+
+	for (int scc = 0; scc < numberOfSccs; scc++) {
+		if (hasCaller[scc]) {
+			continue;
+		}
+		unsigned long long calls = 0;
+		for (int member : indexedGraph.getSccMembers(scc)) {
+			calls += indexedGraph.getNode(member)->getNumberOfCalls();
+		}
+		enteringCalls[scc] = std::max(1ULL, calls);	// main() is called once
+
+		outEdges[entryNode].push_back(edges.size());
+		edges.push_back(DagEdge{entryNode, scc, enteringCalls[scc], 0, 0, false});
+	}
+
+	// every time an SCC is entered, a path ends there
+	for (int scc = 0; scc < numberOfSccs; scc++) {
+		edges[outEdges[scc].front()].calls = enteringCalls[scc];
+	}
+}
+
+/** callees have lower SCC ids, so the number of paths of all children is known */
+void BallLarusEstimatorPhase::numberPaths() {
+
+	std::vector<unsigned long long> pathsFrom(numberOfSccs + 2, 0);
+	pathsFrom[exitNode] = 1;
+
+	std::vector<int> order(numberOfSccs);
+	for (int scc = 0; scc < numberOfSccs; scc++) {
+		order[scc] = scc;
+	}
+	order.push_back(entryNode);
+
+	for (int node : order) {
+		unsigned long long paths = 0;
+		for (int edgeIndex : outEdges[node]) {
+			DagEdge& edge = edges[edgeIndex];
+			edge.value = paths;
+
+			if (pathsFrom[edge.to] > ULLONG_MAX - paths) {
+				overflow = true;
+				paths = ULLONG_MAX;
+			} else {
+				paths += pathsFrom[edge.to];
+			}
+		}
+		pathsFrom[node] = paths;
+	}
+	numberOfPaths = pathsFrom[entryNode];
+}
+
+/**
+ * RN: Kruskal for the maximum spanning tree, the virtual edge EXIT->ENTRY is always on the tree.
+ * The tree edges get potentials with value(u->w) = potential(w) - potential(u), so the increment
+ * of a chord u->w is value(u->w) + potential(u) - potential(w) and the increments on every path
+ * from ENTRY to EXIT sum up to its number. Unsigned arithmetic wraps, which is fine as long as
+ * the number of paths does not overflow.
+ */
+void BallLarusEstimatorPhase::placeIncrements() {
+
+	int exitToEntry = edges.size();
+	edges.push_back(DagEdge{exitNode, entryNode, 0, 0, 0, false});
+
+	std::vector<int> order(edges.size());
+	for (size_t i = 0; i < edges.size(); i++) {
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [this, exitToEntry](int lhs, int rhs) {
+		if (lhs == exitToEntry || rhs == exitToEntry) {
+			return lhs == exitToEntry && rhs != exitToEntry;
+		}
+		return edges[lhs].calls > edges[rhs].calls;
+	});
+
+	UnionFind spanningTree(numberOfSccs + 2);
+	std::vector<std::vector<int> > treeEdges(numberOfSccs + 2);
+	for (int edgeIndex : order) {
+		DagEdge& edge = edges[edgeIndex];
+		if (spanningTree.unite(edge.from, edge.to)) {
+			edge.onSpanningTree = true;
+			treeEdges[edge.from].push_back(edgeIndex);
+			treeEdges[edge.to].push_back(edgeIndex);
+		} else {
+			numberOfChords++;
+			instrumentedEdgeCalls += edge.calls;
+		}
+	}
+
+	std::vector<unsigned long long> potential(numberOfSccs + 2, 0);
+	std::vector<bool> visited(numberOfSccs + 2, false);
+	std::vector<int> workList = {entryNode};
+	visited[entryNode] = true;
+	while (!workList.empty()) {
+		int node = workList.back();
+		workList.pop_back();
+
+		for (int edgeIndex : treeEdges[node]) {
+			DagEdge& edge = edges[edgeIndex];
+			int other = (edge.from == node) ? edge.to : edge.from;
+			if (visited[other]) {
+				continue;
+			}
+			visited[other] = true;
+			potential[other] = (edge.from == node) ? potential[node] + edge.value : potential[node] - edge.value;
+			workList.push_back(other);
+		}
+	}
+
+	for (auto& edge : edges) {
+		if (!edge.onSpanningTree) {
+			edge.increment = (long long) (edge.value + potential[edge.from] - potential[edge.to]);
+		}
+	}
+}
+
+/** one line per call edge with an increment: caller, callee, increment, calls */
+void BallLarusEstimatorPhase::writeIncrements(const IndexedCallgraph& indexedGraph) {
+
+	std::string filename = config->outputPath + "/bl-" + config->appName + "-" + name + ".txt";
+	std::ofstream outfile(filename, std::ofstream::out);
+
+	outfile << "# " << (overflow ? "more than " : "") << numberOfPaths << " call paths, "
+			<< numberOfChords << " increments" << std::endl;
+	if (overflow) {
+		return;		// the increments are meaningless
+	}
+
+	for (auto& edge : edges) {
+		if (edge.onSpanningTree) {
+			continue;
+		}
+
+		if (edge.from == entryNode) {
+			for (int member : indexedGraph.getSccMembers(edge.to)) {
+				outfile << "ENTRY\t" << indexedGraph.getNode(member)->getFunctionName()
+						<< "\t" << edge.increment << "\t" << edge.calls << std::endl;
+			}
+		} else if (edge.to == exitNode) {
+			for (int member : indexedGraph.getSccMembers(edge.from)) {
+				outfile << indexedGraph.getNode(member)->getFunctionName() << "\tEXIT"
+						<< "\t" << edge.increment << "\t" << edge.calls << std::endl;
+			}
+		} else {
+			for (int member : indexedGraph.getSccMembers(edge.from)) {
+				auto memberNode = indexedGraph.getNode(member);
+				for (int child : indexedGraph.getChildren(member)) {
+					if (indexedGraph.getScc(child) == edge.to) {
+						auto childNode = indexedGraph.getNode(child);
+						outfile << memberNode->getFunctionName() << "\t" << childNode->getFunctionName()
+								<< "\t" << edge.increment << "\t" << childNode->getNumberOfCalls(memberNode) << std::endl;
+					}
+				}
+			}
+		}
+	}
+}
+
+void BallLarusEstimatorPhase::printAdditionalReport() {
+	EstimatorPhase::printAdditionalReport();
+
+	std::cout << "\t" << "call paths: " << (overflow ? "more than " : "") << numberOfPaths
+			<< " | SCCs: " << numberOfSccs
+			<< " | increments on " << numberOfChords << " of " << edges.size() << " edges"
+			<< " | unnumbered calls inside of SCCs: " << unnumberedCalls << std::endl;
+	if (overflow) {
+		std::cout << "\t" << "the number of call paths overflows, no increments written" << std::endl;
+	}
+}
@@ -0,0 +1,55 @@
+#ifndef BALLLARUSESTIMATORPHASE_H_
+#define BALLLARUSESTIMATORPHASE_H_
+
+#include "EstimatorPhase.h"
+#include "IndexedCallgraph.h"
+#include "UnionFind.h"
+
+#include <vector>
+
+/**
+ * RN: Ball-Larus path numbering of the call paths, i.e., every call path from main() to a function
+ * gets a unique number in [0, numberOfPaths).
+ * The numbering runs on the condensation of the call graph, calls inside of an SCC are not numbered.
+ * A virtual ENTRY calls all roots and every function has a virtual edge to EXIT (the path ends there).
+ * Only the edges outside of a maximum spanning tree (weighted by the calls) get an increment,
+ * these increments are written to <outputPath>/bl-<app>-<phase>.txt.
+ */
+class BallLarusEstimatorPhase : public EstimatorPhase {
+public:
+	BallLarusEstimatorPhase();
+	~BallLarusEstimatorPhase() {}
+
+	void modifyGraph(CgNodePtr mainMethod);
+
+protected:
+	void printAdditionalReport();
+
+private:
+	struct DagEdge {
+		int from;
+		int to;
+		unsigned long long calls;
+		unsigned long long value;	// the Ball-Larus edge value
+		long long increment;
+		bool onSpanningTree;
+	};
+
+	void buildDag(const IndexedCallgraph& indexedGraph);
+	void numberPaths();
+	void placeIncrements();
+	void writeIncrements(const IndexedCallgraph& indexedGraph);
+
+	int numberOfSccs;
+	int entryNode;
+	int exitNode;
+	std::vector<DagEdge> edges;
+	std::vector<std::vector<int> > outEdges;	// edge indices per SCC
+
+	unsigned long long numberOfPaths;
+	unsigned long long unnumberedCalls;	// calls inside of SCCs
+	int numberOfChords;
+	bool overflow;
+};
+
+#endif
@@ -0,0 +1,150 @@
+#include "BatchDriver.h"
+
+#include "ThreadPool.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <cerrno>
+#include <sys/stat.h>
+
+const IPCGAnal::IPCGFile& BatchDriver::IPCGFileCache::get(std::string filePath) {
+	Entry* entry;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto& slot = entries[filePath];
+		if (!slot) {
+			slot.reset(new Entry());
+		}
+		entry = slot.get();
+	}
+	// RN: reading happens outside of the lock, so different files are read concurrently
+	std::call_once(entry->once, [entry, filePath]() {
+		entry->file = IPCGAnal::read(filePath);
+	});
+	return entry->file;
+}
+
+std::vector<BatchDriver::Job> BatchDriver::readManifest(std::string manifestFile,
+		const Config& baseConfig, OptionParser parse) {
+
+	std::ifstream in(manifestFile);
+	if (!in.is_open()) {
+		std::cerr << "Can not open manifest: " << manifestFile << std::endl;
+		exit(1);
+	}
+
+	std::vector<Job> jobs;
+	std::map<std::string, int> appNameCount;
+
+	int lineNumber = 0;
+	std::string line;
+	while (std::getline(in, line)) {
+		lineNumber++;
+		line = line.substr(0, line.find('#'));
+
+		std::istringstream tokens(line);
+		std::vector<std::string> words;
+		std::string word;
+		while (tokens >> word) {
+			words.push_back(word);
+		}
+		if (words.empty()) {
+			continue;
+		}
+		if (words.size() < 3) {
+			std::cerr << manifestFile << ":" << lineNumber
+					<< ": expected <ipcg|-> <profile|-> <referenceRuntime> [options]" << std::endl;
+			exit(1);
+		}
+
+		Job job;
+		job.ipcgFile = (words[0] == "-") ? "" : words[0];
+		job.profileFile = (words[1] == "-") ? "" : words[1];
+		if (job.ipcgFile.empty() && job.profileFile.empty()) {
+			std::cerr << manifestFile << ":" << lineNumber << ": neither ipcg nor profile given" << std::endl;
+			exit(1);
+		}
+		job.arguments = std::vector<std::string>(words.begin() + 3, words.end());
+
+		job.config = baseConfig;
+		job.config.referenceRuntime = atof(words[2].c_str());
+		if (!parse(job.arguments, job.config)) {
+			std::cerr << manifestFile << ":" << lineNumber << ": invalid options" << std::endl;
+			exit(1);
+		}
+
+		std::string inputFile = job.profileFile.empty() ? job.ipcgFile : job.profileFile;
+		std::string fileName = inputFile.substr(inputFile.find_last_of('/') + 1);
+		job.config.appName = fileName.substr(0, fileName.find_last_of('.'));
+
+		// the same profile may be analyzed with different options
+		std::string directoryName = job.config.appName;
+		int count = appNameCount[job.config.appName]++;
+		if (count > 0) {
+			directoryName += "-" + std::to_string(count);
+		}
+		job.config.outputPath = baseConfig.outputPath + "/" + directoryName;
+
+		jobs.push_back(job);
+	}
+
+	return jobs;
+}
+
+int BatchDriver::run(std::vector<Job>& jobs, const Config& baseConfig, int numberOfThreads, Analysis analyze) {
+
+	if (!createDirectory(baseConfig.outputPath)) {
+		return EXIT_FAILURE;
+	}
+	for (auto& job : jobs) {
+		if (!createDirectory(job.config.outputPath)) {
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::cout << "Batch: " << jobs.size() << " job(s) on " << numberOfThreads << " thread(s)" << std::endl;
+
+	IPCGFileCache cache;
+	{
+		ThreadPool pool(numberOfThreads);
+		for (auto& job : jobs) {
+			Job* jobPtr = &job;
+			pool.enqueue([jobPtr, &cache, &analyze]() {
+				jobPtr->exitCode = analyze(*jobPtr, cache);
+			});
+		}
+		pool.waitForAll();
+	}
+
+	std::string filename = baseConfig.outputPath + "/batch-summary.tsv";
+	std::ofstream outfile(filename, std::ofstream::out);
+	outfile << "app\tprofile\toutputPath\texitCode\tactualRuntime\treferenceRuntime"
+			<< "\tfastestPhase\tfastestPhaseOvSeconds\tfastestPhaseOvPercent" << std::endl;
+
+	int failedJobs = 0;
+	for (auto& job : jobs) {
+		if (job.exitCode != EXIT_SUCCESS) {
+			failedJobs++;
+		}
+		outfile << job.config.appName << "\t" << job.profileFile << "\t" << job.config.outputPath
+				<< "\t" << job.exitCode << "\t" << job.config.actualRuntime
+				<< "\t" << job.config.referenceRuntime << "\t" << job.config.fastestPhaseName
+				<< "\t" << job.config.fastestPhaseOvSeconds << "\t" << job.config.fastestPhaseOvPercent
+				<< std::endl;
+	}
+
+	std::cout << "Batch: " << (jobs.size() - failedJobs) << " of " << jobs.size()
+			<< " job(s) succeeded, summary in " << filename << std::endl;
+
+	return failedJobs == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+bool BatchDriver::createDirectory(std::string path) {
+	if (mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+		std::cerr << "Can not create directory: " << path << std::endl;
+		return false;
+	}
+	return true;
+}
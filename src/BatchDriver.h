@@ -0,0 +1,55 @@
+#ifndef BATCHDRIVER_H_
+#define BATCHDRIVER_H_
+
+#include "CgHelper.h"
+#include "IPCGReader.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Analyzes many profiles in one process.
+ * Every line of a manifest is one job: "<ipcg|-> <profile|-> <referenceRuntime> [options]",
+ * '#' starts a comment.
+ * Each job gets its own Config and writes into its own directory below the output path.
+ */
+namespace BatchDriver {
+
+	struct Job {
+		std::string ipcgFile;		// empty if there is no ipcg
+		std::string profileFile;	// empty if there is no profile
+		std::vector<std::string> arguments;
+		Config config;
+		int exitCode = EXIT_SUCCESS;
+	};
+
+	/** every ipcg file is read once, even if several jobs ask for it at the same time */
+	class IPCGFileCache {
+	public:
+		const IPCGAnal::IPCGFile& get(std::string filePath);
+	private:
+		struct Entry {
+			std::once_flag once;
+			IPCGAnal::IPCGFile file;
+		};
+		std::mutex mutex;
+		std::map<std::string, std::unique_ptr<Entry> > entries;
+	};
+
+	/** applies the options of a job to its config, returns false on unknown options */
+	typedef std::function<bool(const std::vector<std::string>&, Config&)> OptionParser;
+	typedef std::function<int(Job&, IPCGFileCache&)> Analysis;
+
+	std::vector<Job> readManifest(std::string manifestFile, const Config& baseConfig, OptionParser parse);
+
+	/** runs all jobs on numberOfThreads threads and writes a summary to the output path */
+	int run(std::vector<Job>& jobs, const Config& baseConfig, int numberOfThreads, Analysis analyze);
+
+	bool createDirectory(std::string path);
+};
+
+#endif
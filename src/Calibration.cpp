@@ -0,0 +1,242 @@
+#include "Calibration.h"
+
+#include "CgHelper.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <execinfo.h>	// backtrace()
+#include <pthread.h>
+#include <signal.h>
+
+#define NUM_REPETITIONS 5
+
+namespace {
+
+	typedef std::chrono::steady_clock Clock;
+
+	double nanosSince(Clock::time_point start) {
+		return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+	}
+
+	double median(std::vector<double> values) {
+		std::sort(values.begin(), values.end());
+		return values[values.size() / 2];
+	}
+
+	/** runs the benchmark on numThreads threads at once and returns all results */
+	template<typename T>
+	std::vector<T> runConcurrently(int numThreads, std::function<T()> benchmark) {
+		if (numThreads <= 1) {
+			return std::vector<T>(1, benchmark());
+		}
+
+		std::vector<T> results(numThreads);
+		std::atomic<int> ready(0);
+		std::vector<std::thread> threads;
+		for (int i = 0; i < numThreads; i++) {
+			threads.push_back(std::thread([&, i]() {
+				ready++;
+				while (ready.load() < numThreads) {}	// start all threads at once
+				results[i] = benchmark();
+			}));
+		}
+		for (auto& t : threads) {
+			t.join();
+		}
+		return results;
+	}
+
+	double slowest(const std::vector<double>& results) {
+		return *std::max_element(results.begin(), results.end());
+	}
+
+	//// INSTRUMENTATION PROBE
+
+	/* RN: this is what -finstrument-functions inserts in every function, but with an empty hook */
+	void __attribute__((noinline)) pgoeCalibrationProbe(void* function, void* callSite) {
+		asm volatile("" : : "r"(function), "r"(callSite) : "memory");
+	}
+
+	void __attribute__((noinline)) emptyFunction() {
+		asm volatile("" ::: "memory");
+	}
+
+	void __attribute__((noinline)) probedFunction() {
+		pgoeCalibrationProbe((void*) &probedFunction, __builtin_return_address(0));
+		asm volatile("" ::: "memory");
+		pgoeCalibrationProbe((void*) &probedFunction, __builtin_return_address(0));
+	}
+
+	double benchmarkInstrumentedCall() {
+		const unsigned long long numberOfCalls = 10 * 1000 * 1000;
+
+		std::vector<double> differences;
+		for (int rep = 0; rep < NUM_REPETITIONS; rep++) {
+			auto start = Clock::now();
+			for (unsigned long long i = 0; i < numberOfCalls; i++) {
+				emptyFunction();
+			}
+			double plainNanos = nanosSince(start);
+
+			start = Clock::now();
+			for (unsigned long long i = 0; i < numberOfCalls; i++) {
+				probedFunction();
+			}
+			double probedNanos = nanosSince(start);
+
+			differences.push_back((probedNanos - plainNanos) / numberOfCalls);
+		}
+		return std::max(median(differences), 0.0);
+	}
+
+	//// UNWINDING
+
+	const int unwindStackDepth = 160;
+	const int unwindSteps[] = {1, 2, 4, 8, 16, 32, 64, 128};
+
+	/** measures backtrace() for all entries in unwindSteps once the stack is deep enough */
+	void __attribute__((noinline)) unwindAtDepth(int depth, std::vector<double>& nanosPerSample) {
+		if (depth > 0) {
+			unwindAtDepth(depth - 1, nanosPerSample);
+			asm volatile("" ::: "memory");	// no tail call
+			return;
+		}
+
+		const int numberOfSamples = 20000;
+		void* buffer[256];
+		for (int steps : unwindSteps) {
+			auto start = Clock::now();
+			for (int i = 0; i < numberOfSamples; i++) {
+				backtrace(buffer, steps);
+			}
+			nanosPerSample.push_back(nanosSince(start) / numberOfSamples);
+		}
+	}
+
+	/** linear regression of the unwind costs over the number of unwind steps */
+	std::pair<double, double> benchmarkUnwind() {
+		void* buffer[8];
+		backtrace(buffer, 8);	// the first call loads the unwinder
+
+		std::vector<double> intercepts;
+		std::vector<double> slopes;
+		for (int rep = 0; rep < NUM_REPETITIONS; rep++) {
+			std::vector<double> nanosPerSample;
+			unwindAtDepth(unwindStackDepth, nanosPerSample);
+
+			double n = nanosPerSample.size();
+			double sumX = 0, sumY = 0, sumXY = 0, sumXX = 0;
+			for (size_t i = 0; i < nanosPerSample.size(); i++) {
+				double x = unwindSteps[i];
+				double y = nanosPerSample[i];
+				sumX += x; sumY += y; sumXY += x * y; sumXX += x * x;
+			}
+			double slope = (n * sumXY - sumX * sumY) / (n * sumXX - sumX * sumX);
+			slopes.push_back(slope);
+			intercepts.push_back((sumY - slope * sumX) / n);
+		}
+		return std::make_pair(std::max(median(intercepts), 0.0), std::max(median(slopes), 0.0));
+	}
+
+	//// SAMPLING
+
+	std::atomic<unsigned long long> samplesTaken(0);
+
+	void sampleHandler(int) {
+		samplesTaken.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/**
+	 * RN: the timer signal is sent synchronously to the calling thread, as the kernel does it for ITIMER_PROF.
+	 * This only covers the signal delivery & the handler itself.
+	 * Whatever a real sampler does inside the handler comes on top.
+	 */
+	double benchmarkSample() {
+		const int numberOfSamples = 200 * 1000;
+
+		std::vector<double> nanosPerSample;
+		for (int rep = 0; rep < NUM_REPETITIONS; rep++) {
+			auto start = Clock::now();
+			for (int i = 0; i < numberOfSamples; i++) {
+				pthread_kill(pthread_self(), SIGPROF);
+			}
+			nanosPerSample.push_back(nanosSince(start) / numberOfSamples);
+		}
+		return median(nanosPerSample);
+	}
+
+	unsigned long long roundNanos(double nanos) {
+		return (unsigned long long) std::ceil(nanos);
+	}
+}
+
+Calibration::CalibrationResult Calibration::calibrate(int numThreads) {
+
+	CalibrationResult result;
+
+	result.nanosPerInstrumentedCall = slowest(
+			runConcurrently(numThreads, std::function<double()>(benchmarkInstrumentedCall)));
+
+	result.nanosPerUnwindSample = 0;
+	result.nanosPerUnwindStep = 0;
+	auto unwindResults = runConcurrently(numThreads, std::function<std::pair<double, double>()>(benchmarkUnwind));
+	for (auto r : unwindResults) {
+		result.nanosPerUnwindSample = std::max(result.nanosPerUnwindSample, r.first);
+		result.nanosPerUnwindStep = std::max(result.nanosPerUnwindStep, r.second);
+	}
+
+	struct sigaction action;
+	struct sigaction oldAction;
+	action.sa_handler = sampleHandler;
+	sigemptyset(&action.sa_mask);
+	action.sa_flags = SA_RESTART;
+	sigaction(SIGPROF, &action, &oldAction);
+
+	result.nanosPerSample = slowest(runConcurrently(numThreads, std::function<double()>(benchmarkSample)));
+
+	sigaction(SIGPROF, &oldAction, nullptr);
+	if (samplesTaken.load() == 0) {
+		std::cerr << "Calibration: no samples were taken" << std::endl;
+		result.nanosPerSample = CgConfig::nanosPerSample;
+	}
+
+	return result;
+}
+
+int Calibration::run(int numThreads, std::string costModelFile) {
+
+	std::cout << "Calibrating cost model with " << numThreads << " thread(s)" << std::endl;
+
+	CalibrationResult result = calibrate(numThreads);
+
+	std::cout << std::setprecision(4)
+			<< "    " << "instrumentedCall: " << result.nanosPerInstrumentedCall << " ns"
+			<< " (was " << CgConfig::nanosPerInstrumentedCall << " ns)" << std::endl
+			<< "    " << "unwindSample: " << result.nanosPerUnwindSample << " ns"
+			<< " (was " << CgConfig::nanosPerUnwindSample << " ns)"
+			<< " | unwindStep: " << result.nanosPerUnwindStep << " ns"
+			<< " (was " << CgConfig::nanosPerUnwindStep << " ns)" << std::endl
+			<< "    " << "sample: " << result.nanosPerSample << " ns"
+			<< " (was " << CgConfig::nanosPerSample << " ns)" << std::endl;
+
+	CgConfig::nanosPerInstrumentedCall = std::max(roundNanos(result.nanosPerInstrumentedCall), 1ULL);
+	CgConfig::nanosPerUnwindSample = roundNanos(result.nanosPerUnwindSample);
+	CgConfig::nanosPerUnwindStep = std::max(roundNanos(result.nanosPerUnwindStep), 1ULL);
+	CgConfig::nanosPerSample = std::max(roundNanos(result.nanosPerSample), 1ULL);
+
+	if (!CgConfig::writeCostModel(costModelFile)) {
+		std::cerr << "Calibration: can not write cost model to " << costModelFile << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::cout << "Cost model written to " << costModelFile << std::endl;
+
+	return EXIT_SUCCESS;
+}
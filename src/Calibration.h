@@ -0,0 +1,25 @@
+#ifndef CALIBRATION_H_
+#define CALIBRATION_H_
+
+#include <string>
+
+/**
+ * Micro-benchmarks the cost constants of CgConfig on the local host.
+ * The results are written to a cost-model file that is read on startup.
+ */
+namespace Calibration {
+
+	struct CalibrationResult {
+		double nanosPerInstrumentedCall;
+		double nanosPerUnwindSample;
+		double nanosPerUnwindStep;
+		double nanosPerSample;
+	};
+
+	/** all benchmarks are run by numThreads threads at once, the slowest thread counts */
+	CalibrationResult calibrate(int numThreads);
+
+	int run(int numThreads, std::string costModelFile);
+}
+
+#endif
@@ -27,18 +27,27 @@ CgNodePtr Callgraph::findMain() {
 }
 
 CgNodePtr Callgraph::findNode(std::string functionName) {
-	for (auto node : *this ) {
-
-		auto fName = node->getFunctionName();
-		if (fName == functionName) {
-			return node;
-		}
+	// RN: nodes are ordered by their function name
+	auto it = graph.find(std::make_shared<CgNode>(functionName));
+	if (it != graph.end()) {
+		return *it;
 	}
 	return nullptr;
 }
 
 void Callgraph::insert(CgNodePtr node) {
-	graph.insert(node);
+	if (graph.insert(node).second) {
+		structureChanged = true;
+	}
+}
+
+bool Callgraph::contains(CgNodePtr node) const {
+	return graph.find(node) != graph.end();
+}
+
+void Callgraph::clear() {
+	graph.clear();
+	structureChanged = true;
 }
 
 void Callgraph::eraseInstrumentedNode(CgNodePtr node) {
@@ -91,6 +100,7 @@ void Callgraph::erase(CgNodePtr node, bool rewireAfterDeletion, bool force) {
 	}
 
 	graph.erase(node);
+	structureChanged = true;
 
 //	std::cout << "  Erasing node: " << *node << std::endl;
 //	std::cout << "  UseCount: " << node.use_count() << std::endl;
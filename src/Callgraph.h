@@ -11,6 +11,8 @@ public:
 	CgNodePtr findNode(std::string functionName);
 
 	void insert(CgNodePtr node);
+	bool contains(CgNodePtr node) const;
+	void clear();
 
 	void eraseInstrumentedNode(CgNodePtr node);
 
@@ -23,9 +25,14 @@ public:
 
 	size_t size();
     CgNodePtrSet getGraph();
+
+	// set whenever nodes or edges change, marker positions have to be recomputed then
+	bool hasStructureChanged() const { return structureChanged; }
+	void setStructureChanged(bool changed = true) { structureChanged = changed; }
 private:
 	// this set represents the call graph during the actual computation
 	CgNodePtrSet graph;
+	bool structureChanged = true;
 };
 
 #endif
@@ -1,11 +1,26 @@
 #include "CallgraphManager.h"
+#include "PlanEmitter.h"
+#include "Trace.h"
 
 CallgraphManager::CallgraphManager(Config* config) : config(config) {
 }
 
 CgNodePtr CallgraphManager::findOrCreateNode(std::string name, double timeInSeconds) {
 	if (graphMapping.find(name) != graphMapping.end()) {
-		return graphMapping.find(name)->second;
+		CgNodePtr node = graphMapping.find(name)->second;
+		if (!graph.contains(node)) {
+			// RN: the node was erased by an earlier phase, it comes back without its old edges
+			for (auto parent : CgNodePtrSet(node->getParentNodes())) {
+				node->removeParentNode(parent);
+				parent->removeChildNode(node);
+			}
+			for (auto child : CgNodePtrSet(node->getChildNodes())) {
+				node->removeChildNode(child);
+				child->removeParentNode(node);
+			}
+			graph.insert(node);
+		}
+		return node;
 	} else {
 		CgNodePtr node = std::make_shared<CgNode>(name);
 		graphMapping.insert(std::pair<std::string, CgNodePtr>(name, node));
@@ -31,6 +46,9 @@ void CallgraphManager::putEdge(std::string parentName, std::string childName) {
 	CgNodePtr parentNode = findOrCreateNode(parentName);
 	CgNodePtr childNode = findOrCreateNode(childName);
 
+	if (parentNode->getChildNodes().find(childNode) == parentNode->getChildNodes().end()) {
+		graph.setStructureChanged();
+	}
 	parentNode->addChildNode(childNode);
 	childNode->addParentNode(parentNode);
 }
@@ -52,6 +70,22 @@ void CallgraphManager::putEdge(std::string parentName, std::string parentFilenam
 	childNode->addCallData(parentNode, numberOfCalls, timeInSeconds);
 }
 
+void CallgraphManager::putCallsite(std::string parentName, std::string childName, std::string filename, int line,
+		unsigned long long numberOfCalls, double inclusiveTimeInSeconds) {
+	callsites.putCallsite(parentName, childName, filename, line, numberOfCalls, inclusiveTimeInSeconds);
+}
+
+int CallgraphManager::putContext(int parentContext, std::string name) {
+	if (!contextTree) {
+		contextTree = std::make_shared<CallingContextTree>();
+	}
+	return contextTree->addContext(parentContext, name, 0, .0);
+}
+
+void CallgraphManager::putContextCallData(int context, unsigned long long numberOfCalls, double timeInSeconds) {
+	contextTree->addCallData(context, numberOfCalls, timeInSeconds);
+}
+
 void CallgraphManager::registerEstimatorPhase(EstimatorPhase* phase, bool noReport) {
 	phases.push(phase);
 	phase->injectConfig(config);
@@ -63,26 +97,69 @@ void CallgraphManager::registerEstimatorPhase(EstimatorPhase* phase, bool noRepo
 }
 
 void CallgraphManager::finalizeGraph() {
-	graphMapping.clear();
+	TRACE_ZONE("CallgraphManager::finalizeGraph");
+
+	// marker positions & dependent conjunctions only depend on the structure of the graph
+	if (graph.hasStructureChanged()) {
+		for (auto node : graph) {
+			node->getMarkerPositions().clear();
+			node->getDependentConjunctions().clear();
+			node->updateStaticNodeAttributes();
+		}
+
+		for (auto node : graph) {
+			CgNodePtrSet markerPositions = CgHelper::getPotentialMarkerPositions(node);
+			node->getMarkerPositions().insert(markerPositions.begin(), markerPositions.end());
+
+			std::for_each(markerPositions.begin(), markerPositions.end(),
+					[&node](const CgNodePtr& markerPosition) { markerPosition->getDependentConjunctions().insert(node); });
+		}
+		graph.setStructureChanged(false);
+	}
 
 	// also update all node attributes
 	for (auto node : graph) {
-
 		if (config->samplesFile.empty()) {
-			node->updateNodeAttributes();
+			node->updateDynamicNodeAttributes();
 		} else {
-			node->updateNodeAttributes(false);
+			node->updateDynamicNodeAttributes(false);
 		}
+	}
+}
+
+void CallgraphManager::saveStaticState() {
+	// RN: the static phases may have changed the structure, the saved marker positions have to be up to date
+	finalizeGraph();
+
+	staticState.graphMapping = graphMapping;
+	staticState.nodes = CgNodePtrSet(graph.begin(), graph.end());
+	staticState.nodeStates.clear();
+	for (auto& nameAndNode : graphMapping) {
+		staticState.nodeStates[nameAndNode.second] = nameAndNode.second->getStaticState();
+	}
+}
 
-		CgNodePtrSet markerPositions = CgHelper::getPotentialMarkerPositions(node);
-		node->getMarkerPositions().insert(markerPositions.begin(), markerPositions.end());
+void CallgraphManager::restoreStaticState() {
+	graphMapping = staticState.graphMapping;
+	callsites.clear();
+	contextTree.reset();
+	reports.clear();	// the reports of the static phases
 
-		std::for_each(markerPositions.begin(), markerPositions.end(),
-				[&node](const CgNodePtr& markerPosition) { markerPosition->getDependentConjunctions().insert(node); });
+	graph.clear();
+	for (auto node : staticState.nodes) {
+		graph.insert(node);
+	}
+	for (auto& nameAndNode : graphMapping) {
+		auto node = nameAndNode.second;
+		node->restoreStaticState(staticState.nodeStates[node]);
+		node->resetCallData();
+		node->reset();
 	}
+	graph.setStructureChanged(false);
 }
 
 void CallgraphManager::thatOneLargeMethod() {
+	TRACE_ZONE("CallgraphManager::thatOneLargeMethod", config->appName);
 
 	finalizeGraph();
 	auto mainFunction = graph.findMain();
@@ -94,16 +171,23 @@ void CallgraphManager::thatOneLargeMethod() {
 
 	while(!phases.empty()) {
 		EstimatorPhase* phase = phases.front();
+		TRACE_ZONE(phase->getName());
 
 #if BENCHMARK_PHASES
 		auto startTime = std::chrono::system_clock::now();
 #endif
-		phase->modifyGraph(mainFunction);
+		{
+			TRACE_ZONE("EstimatorPhase::modifyGraph");
+			phase->modifyGraph(mainFunction);
+		}
 		phase->generateReport();
 
 		phase->printReport();
 
 		CgReport report = phase->getReport();
+		if (!report.metaPhase) {
+			reports.push_back(report);
+		}
 #if PRINT_DOT_AFTER_EVERY_PHASE
 		printDOT(report.phaseName);
 #endif	// PRINT_DOT_AFTER_EVERY_PHASE
@@ -113,6 +197,9 @@ void CallgraphManager::thatOneLargeMethod() {
 #if DUMP_UNWOUND_NAMES
 		dumpUnwoundNames(report);
 #endif	// DUMP_UNWOUND_NAMES
+		if (!report.metaPhase) {
+			emitPlans(report);
+		}
 
 #if BENCHMARK_PHASES
 		auto endTime = std::chrono::system_clock::now();
@@ -129,11 +216,15 @@ void CallgraphManager::thatOneLargeMethod() {
 #if PRINT_FINAL_DOT
 	printDOT("final");
 #endif
+#if DUMP_SUMMARY
+	dumpSummary();
+#endif	// DUMP_SUMMARY
 }
 
 void CallgraphManager::printDOT(std::string prefix) {
+	TRACE_ZONE("CallgraphManager::printDOT", prefix);
 
-	std::string filename = "out/callgraph-" + config->appName + "-" + prefix + ".dot";
+	std::string filename = config->outputPath + "/callgraph-" + config->appName + "-" + prefix + ".dot";
 	std::ofstream outfile(filename, std::ofstream::out);
 
 	outfile << "digraph callgraph {\nnode [shape=oval]\n";
@@ -195,10 +286,10 @@ void CallgraphManager::printDOT(std::string prefix) {
 }
 
 void CallgraphManager::dumpInstrumentedNames(CgReport report) {
-	std::string filename = "out/instrumented-" + config->appName + "-" + report.phaseName + ".txt";
-    std::size_t found = filename.find("out/instrumented-"+config->appName+"-"+"Incl");
+	std::string filename = config->outputPath + "/instrumented-" + config->appName + "-" + report.phaseName + ".txt";
+    std::size_t found = filename.find(config->outputPath + "/instrumented-"+config->appName+"-"+"Incl");
 	if (found!=std::string::npos) {
-        filename = "out/instrumented-" + config->appName+".txt";
+        filename = config->outputPath + "/instrumented-" + config->appName+".txt";
     }
 	std::ofstream outfile(filename, std::ofstream::out);
 
@@ -213,7 +304,7 @@ void CallgraphManager::dumpInstrumentedNames(CgReport report) {
 }
 
 void CallgraphManager::dumpUnwoundNames(CgReport report) {
-	std::string filename = "out/unw-" + config->appName + "-" + report.phaseName + ".txt";
+	std::string filename = config->outputPath + "/unw-" + config->appName + "-" + report.phaseName + ".txt";
 	std::ofstream outfile(filename, std::ofstream::out);
 
 	for (auto pair : report.unwoundNames) {
@@ -224,6 +315,32 @@ void CallgraphManager::dumpUnwoundNames(CgReport report) {
 	}
 }
 
+void CallgraphManager::emitPlans(CgReport report) {
+	TRACE_ZONE("CallgraphManager::emitPlans");
+	for (auto& format : config->planFormats) {
+		auto emitter = PlanEmitter::create(format);
+		std::string filename = config->outputPath + "/plan-" + config->appName + "-" + report.phaseName
+				+ "." + emitter->getExtension();
+		std::ofstream outfile(filename, std::ofstream::out);
+		emitter->emit(report, graph, outfile);
+	}
+}
+
+/** one line per (non meta) phase, the fastest phase is also in Config */
+void CallgraphManager::dumpSummary() {
+	std::string filename = config->outputPath + "/summary-" + config->appName + ".tsv";
+	std::ofstream outfile(filename, std::ofstream::out);
+
+	outfile << "phase\tinstrumentedMethods\tinstrumentedCalls\tinstrOvSeconds\tunwindOvSeconds"
+			<< "\tsamplingOvSeconds\toverallSeconds\toverallPercent" << std::endl;
+	for (auto& report : reports) {
+		outfile << report.phaseName << "\t" << report.instrumentedMethods << "\t" << report.instrumentedCalls
+				<< "\t" << report.instrOvSeconds << "\t" << report.unwindOvSeconds
+				<< "\t" << report.samplingOvSeconds << "\t" << report.overallSeconds
+				<< "\t" << report.overallPercent << std::endl;
+	}
+}
+
 std::map<std::string, CgNodePtr> CallgraphManager::getGraphMapping(CallgraphManager *cg){
 	return cg->graphMapping;
 };
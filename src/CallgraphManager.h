@@ -9,11 +9,14 @@
 
 #include "CgNode.h"
 #include "Callgraph.h"
+#include "CallsiteGraph.h"
+#include "CallingContextTree.h"
 #include "EstimatorPhase.h"
 
 #define PRINT_DOT_AFTER_EVERY_PHASE true
 #define DUMP_INSTRUMENTED_NAMES true
 #define DUMP_UNWOUND_NAMES true
+#define DUMP_SUMMARY true
 
 class CallgraphManager {
 
@@ -23,6 +26,13 @@ public:
 	void putEdge(std::string parentName, std::string parentFilename, int parentLine,
 			std::string childName, unsigned long long numberOfCalls, double timeInSeconds);
 
+	void putCallsite(std::string parentName, std::string childName, std::string filename, int line,
+			unsigned long long numberOfCalls, double inclusiveTimeInSeconds);
+
+	/** returns the id of the new context, see CallingContextTree::addContext() */
+	int putContext(int parentContext, std::string name);
+	void putContextCallData(int context, unsigned long long numberOfCalls, double timeInSeconds);
+
 	void putNumberOfStatements(std::string name, int numberOfStatements);
 	void putNumberOfSamples(std::string name, unsigned long long  numberOfSamples);
 	CgNodePtr findOrCreateNode(std::string name, double timeInSeconds = 0.0);
@@ -31,11 +41,23 @@ public:
 
 	void thatOneLargeMethod();	// TODO RN: rename
 
+	/**
+	 * Incremental mode: remember the finalized graph after the static (ipcg) phases,
+	 * so the next profile can be read into it without rebuilding it.
+	 */
+	void saveStaticState();
+	/** drops all profile data and structural changes since saveStaticState() */
+	void restoreStaticState();
+
 	// Delegates to the underlying graph
 	CgNodePtrSet::iterator begin(){return graph.begin();};
 	CgNodePtrSet::iterator end(){return graph.end();};
 	size_t size(){return graph.size();};
 
+	const CallsiteGraph& getCallsiteGraph() const { return callsites; }
+	/** nullptr if the profile has not been read with --cct */
+	std::shared_ptr<const CallingContextTree> getContextTree() const { return contextTree; }
+
 	void printDOT(std::string prefix);
     std::map<std::string, CgNodePtr> getGraphMapping(CallgraphManager* );
     Callgraph getCallgraph(CallgraphManager *);
@@ -44,10 +66,21 @@ private:
 	std::map<std::string, CgNodePtr> graphMapping;
 	// this set represents the call graph during the actual computation
 	Callgraph graph;
+	// only filled with --callsites
+	CallsiteGraph callsites;
+	// only with --cct, shared by the copies of the manager
+	std::shared_ptr<CallingContextTree> contextTree;
 	Config* config;
 
 	// estimator phases run in a defined order
 	std::queue<EstimatorPhase*> phases;
+	std::vector<CgReport> reports;
+
+	struct StaticState {
+		std::map<std::string, CgNodePtr> graphMapping;
+		CgNodePtrSet nodes;
+		std::map<CgNodePtr, CgNodeStaticState> nodeStates;
+	} staticState;
 
 	void putEdge(std::string parentName, std::string childName);
 
@@ -55,6 +88,8 @@ private:
 
 	void dumpInstrumentedNames(CgReport report);
 	void dumpUnwoundNames(CgReport report);
+	void emitPlans(CgReport report);
+	void dumpSummary();
 };
 
 
@@ -0,0 +1,159 @@
+#include "CallingContextTree.h"
+
+#include <algorithm>
+#include <tuple>
+
+int CallingContextTree::addContext(int parent, const std::string& functionName, unsigned long long numberOfCalls,
+		double runtimeInSeconds) {
+
+	auto it = functionIds.find(functionName);
+	if (it == functionIds.end()) {
+		it = functionIds.insert(std::make_pair(functionName, (int) functionNames.size())).first;
+		functionNames.push_back(functionName);
+	}
+
+	parents.push_back(parent);
+	functions.push_back(it->second);
+	calls.push_back(numberOfCalls);
+	runtimes.push_back(runtimeInSeconds);
+	return parents.size() - 1;
+}
+
+void CallingContextTree::addCallData(int context, unsigned long long numberOfCalls, double runtimeInSeconds) {
+	calls[context] += numberOfCalls;
+	runtimes[context] += runtimeInSeconds;
+}
+
+int CallingContextTree::getFunctionId(const std::string& functionName) const {
+	auto it = functionIds.find(functionName);
+	return (it == functionIds.end()) ? -1 : it->second;
+}
+
+std::vector<double> CallingContextTree::getInclusiveRuntimes() const {
+	std::vector<double> inclusiveRuntimes(runtimes);
+	for (size_t context = size(); context-- > 0;) {
+		if (parents[context] >= 0) {
+			inclusiveRuntimes[parents[context]] += inclusiveRuntimes[context];
+		}
+	}
+	return inclusiveRuntimes;
+}
+
+void CallingContextTree::getContextsPerFunction(std::vector<int>& offsets, std::vector<int>& contexts) const {
+	offsets.assign(functionNames.size() + 1, 0);
+	for (int function : functions) {
+		offsets[function + 1]++;
+	}
+	for (size_t function = 0; function < functionNames.size(); function++) {
+		offsets[function + 1] += offsets[function];
+	}
+
+	contexts.resize(size());
+	std::vector<int> next(offsets.begin(), offsets.end() - 1);
+	for (size_t context = 0; context < size(); context++) {
+		contexts[next[functions[context]]++] = context;
+	}
+}
+
+/**
+ * RN: partition refinement per function. At level L the contexts of a function are in the same group
+ * if the last L functions of their paths are the same. A selected context is told apart at the level
+ * where its group has no other member. Groups without a selected context are not refined any further.
+ */
+std::vector<int> CallingContextTree::getDistinguishingDepths(const std::vector<bool>& selectedContexts) const {
+
+	std::vector<int> offsets;
+	std::vector<int> contexts;
+	getContextsPerFunction(offsets, contexts);
+
+	struct Member {
+		int group;
+		int key;	// the function at the current level, -1 above the root
+		int ancestor;
+		bool selected;
+	};
+	std::vector<Member> members;
+	std::vector<int> groupSizes;
+	std::vector<bool> groupHasSelected;
+	std::vector<bool> groupAboveRoot;
+
+	std::vector<int> depths(functionNames.size(), 0);
+	for (size_t function = 0; function < functionNames.size(); function++) {
+		members.clear();
+		bool hasSelected = false;
+		for (int i = offsets[function]; i < offsets[function + 1]; i++) {
+			bool selected = selectedContexts[contexts[i]];
+			members.push_back(Member{0, (int) function, contexts[i], selected});
+			hasSelected = hasSelected || selected;
+		}
+		if (!hasSelected) {
+			continue;
+		}
+
+		int level = 1;
+		int numberOfGroups = 1;
+		while (true) {
+			groupSizes.assign(numberOfGroups, 0);
+			groupHasSelected.assign(numberOfGroups, false);
+			groupAboveRoot.assign(numberOfGroups, true);
+			for (auto& member : members) {
+				groupSizes[member.group]++;
+				groupHasSelected[member.group] = groupHasSelected[member.group] || member.selected;
+				groupAboveRoot[member.group] = groupAboveRoot[member.group] && member.ancestor < 0;
+			}
+
+			// identical paths can not be told apart, their whole path is taken
+			size_t numberOfOpenMembers = 0;
+			for (auto& member : members) {
+				bool resolved = groupSizes[member.group] == 1 || groupAboveRoot[member.group];
+				if (resolved && member.selected) {
+					depths[function] = std::max(depths[function], level);
+				}
+				if (!resolved && groupHasSelected[member.group]) {
+					members[numberOfOpenMembers++] = member;
+				}
+			}
+			members.resize(numberOfOpenMembers);
+			if (members.empty()) {
+				break;
+			}
+
+			level++;
+			for (auto& member : members) {
+				member.ancestor = (member.ancestor < 0) ? -1 : parents[member.ancestor];
+				member.key = (member.ancestor < 0) ? -1 : functions[member.ancestor];
+			}
+			std::sort(members.begin(), members.end(), [](const Member& lhs, const Member& rhs) {
+				return std::tie(lhs.group, lhs.key) < std::tie(rhs.group, rhs.key);
+			});
+			numberOfGroups = 0;
+			int previousGroup = -1;
+			int previousKey = 0;
+			for (auto& member : members) {
+				if (member.group != previousGroup || member.key != previousKey) {
+					previousGroup = member.group;
+					previousKey = member.key;
+					numberOfGroups++;
+				}
+				member.group = numberOfGroups - 1;
+			}
+		}
+	}
+	return depths;
+}
+
+std::vector<int> CallingContextTree::getFunctionsOnPaths(int function, int depth, const std::vector<int>& offsets,
+		const std::vector<int>& contexts) const {
+
+	std::vector<int> functionsOnPaths;
+	for (int i = offsets[function]; i < offsets[function + 1]; i++) {
+		int context = contexts[i];
+		for (int level = 0; level < depth && context >= 0; level++) {
+			functionsOnPaths.push_back(functions[context]);
+			context = parents[context];
+		}
+	}
+	std::sort(functionsOnPaths.begin(), functionsOnPaths.end());
+	functionsOnPaths.erase(std::unique(functionsOnPaths.begin(), functionsOnPaths.end()), functionsOnPaths.end());
+	return functionsOnPaths;
+}
@@ -0,0 +1,63 @@
+#ifndef CALLINGCONTEXTTREE_H_
+#define CALLINGCONTEXTTREE_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * The calling context tree of a profile as it is in the Cube cnodes, i.e., one context per call path.
+ * The tree is stored column-wise with 24 bytes per context: the parent index, the interned
+ * function id and the calls & exclusive runtime of the context. A context is always added after its
+ * parent, so the parent index is smaller and the inclusive runtimes are one backward pass.
+ * Contexts that only differ in the callsite are not merged, function probes can not tell them apart.
+ * Only filled with --cct, see CallgraphManager::putContext().
+ */
+class CallingContextTree {
+public:
+	/** returns the id of the new context, parent is -1 for a root */
+	int addContext(int parent, const std::string& functionName, unsigned long long numberOfCalls,
+			double runtimeInSeconds);
+	void addCallData(int context, unsigned long long numberOfCalls, double runtimeInSeconds);
+
+	size_t size() const { return parents.size(); }
+	bool empty() const { return parents.empty(); }
+	size_t getNumberOfFunctions() const { return functionNames.size(); }
+
+	int getParent(int context) const { return parents[context]; }
+	int getFunction(int context) const { return functions[context]; }
+	unsigned long long getNumberOfCalls(int context) const { return calls[context]; }
+	double getRuntimeInSeconds(int context) const { return runtimes[context]; }
+
+	const std::string& getFunctionName(int function) const { return functionNames[function]; }
+	/** -1 if the function is not in the tree */
+	int getFunctionId(const std::string& functionName) const;
+
+	std::vector<double> getInclusiveRuntimes() const;
+	/** the contexts of every function, CSR: contexts of f are [offsets[f], offsets[f + 1]) */
+	void getContextsPerFunction(std::vector<int>& offsets, std::vector<int>& contexts) const;
+
+	/**
+	 * The number of functions at the end of a call path (including the function itself) that tell
+	 * the selected contexts of a function apart from all its other contexts, the maximum per function.
+	 * 0 for a function without selected contexts, 1 for a function with a single context. A context
+	 * whose path is the end of another path of its function needs its whole path, so depth + 1.
+	 * Contexts with the same path (different callsites only) are given their whole path as well.
+	 */
+	std::vector<int> getDistinguishingDepths(const std::vector<bool>& selectedContexts) const;
+
+	/** the functions at the end of the call paths of the function, up to the given depth */
+	std::vector<int> getFunctionsOnPaths(int function, int depth, const std::vector<int>& offsets,
+			const std::vector<int>& contexts) const;
+
+private:
+	std::vector<int> parents;
+	std::vector<int> functions;
+	std::vector<unsigned long long> calls;
+	std::vector<double> runtimes;
+
+	std::vector<std::string> functionNames;
+	std::unordered_map<std::string, int> functionIds;
+};
+
+#endif
@@ -0,0 +1,54 @@
+#include "CallsiteGraph.h"
+
+#include <set>
+
+namespace {
+	const std::vector<int> noCallsites;
+}
+
+void CallsiteGraph::putCallsite(std::string caller, std::string callee, std::string filename, int line,
+		unsigned long long numberOfCalls, double inclusiveRuntimeInSeconds) {
+
+	auto key = std::make_tuple(caller, callee, filename, line);
+	auto it = ids.find(key);
+	if (it == ids.end()) {
+		int id = callsites.size();
+		it = ids.insert(std::make_pair(key, id)).first;
+		callsites.push_back(Callsite{caller, callee, filename, line, 0, .0});
+		callsitesTo[callee].push_back(id);
+		callsitesFrom[caller].push_back(id);
+	}
+
+	Callsite& callsite = callsites[it->second];
+	callsite.numberOfCalls += numberOfCalls;
+	callsite.inclusiveRuntimeInSeconds += inclusiveRuntimeInSeconds;
+}
+
+void CallsiteGraph::clear() {
+	callsites.clear();
+	ids.clear();
+	callsitesTo.clear();
+	callsitesFrom.clear();
+}
+
+const std::vector<int>& CallsiteGraph::getCallsitesTo(const std::string& callee) const {
+	auto it = callsitesTo.find(callee);
+	return (it == callsitesTo.end()) ? noCallsites : it->second;
+}
+
+const std::vector<int>& CallsiteGraph::getCallsitesFrom(const std::string& caller) const {
+	auto it = callsitesFrom.find(caller);
+	return (it == callsitesFrom.end()) ? noCallsites : it->second;
+}
+
+int CallsiteGraph::getNumberOfSplitEdges() const {
+	std::set<std::pair<std::string, std::string> > edges;
+	std::set<std::pair<std::string, std::string> > splitEdges;
+	for (auto& callsite : callsites) {
+		auto edge = std::make_pair(callsite.caller, callsite.callee);
+		if (!edges.insert(edge).second) {
+			splitEdges.insert(edge);
+		}
+	}
+	return splitEdges.size();
+}
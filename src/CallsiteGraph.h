@@ -0,0 +1,52 @@
+#ifndef CALLSITEGRAPH_H_
+#define CALLSITEGRAPH_H_
+
+#include <map>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+/** one call instruction: the calls of a caller to a callee from one line */
+struct Callsite {
+	std::string caller;
+	std::string callee;
+	std::string filename;
+	int line;
+
+	unsigned long long numberOfCalls;
+	double inclusiveRuntimeInSeconds;
+};
+
+/**
+ * The call graph as a multigraph with one edge per callsite. The Callgraph collapses all callsites
+ * of a caller/callee pair into one edge, here they stay apart, so a hot callsite can be told from
+ * the cold callsites next to it. The calls and runtimes of all call paths through a callsite are summed.
+ * Only filled with --callsites, see CallgraphManager::putCallsite().
+ */
+class CallsiteGraph {
+public:
+	void putCallsite(std::string caller, std::string callee, std::string filename, int line,
+			unsigned long long numberOfCalls, double inclusiveRuntimeInSeconds);
+	void clear();
+
+	size_t size() const { return callsites.size(); }
+	bool empty() const { return callsites.empty(); }
+	const Callsite& get(int id) const { return callsites[id]; }
+
+	/** ids of the callsites that call the function, empty if there are none */
+	const std::vector<int>& getCallsitesTo(const std::string& callee) const;
+	const std::vector<int>& getCallsitesFrom(const std::string& caller) const;
+
+	/** number of caller/callee pairs with more than one callsite */
+	int getNumberOfSplitEdges() const;
+
+private:
+	std::vector<Callsite> callsites;
+	std::map<std::tuple<std::string, std::string, std::string, int>, int> ids;
+
+	std::unordered_map<std::string, std::vector<int> > callsitesTo;
+	std::unordered_map<std::string, std::vector<int> > callsitesFrom;
+};
+
+#endif
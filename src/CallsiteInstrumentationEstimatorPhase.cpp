@@ -0,0 +1,73 @@
+#include "CallsiteInstrumentationEstimatorPhase.h"
+
+CallsiteInstrumentationEstimatorPhase::CallsiteInstrumentationEstimatorPhase(const CallsiteGraph& callsites,
+		double runtimeThreshold) :
+		EstimatorPhase("CallsiteRuntime" + std::to_string(runtimeThreshold)),
+		callsites(callsites),
+		runtimeThreshold(runtimeThreshold),
+		numberOfReplacedFunctions(0),
+		savedCalls(0),
+		unmeasuredSeconds(.0) {
+}
+
+void CallsiteInstrumentationEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
+
+	if (callsites.empty()) {
+		std::cerr << "CallsiteInstrumentation: the profile has no callsites, the plan stays as it is" << std::endl;
+		return;
+	}
+
+	// the plan of the preceding phase, it does not change while the probes are moved
+	CgNodePtrSet instrumentedNodes;
+	for (auto node : *graph) {
+		if (node->isInstrumented()) {
+			instrumentedNodes.insert(node);
+		}
+	}
+
+	for (auto node : instrumentedNodes) {
+		std::vector<int> measuredCallsites;
+		unsigned long long callsiteCalls = 0;
+		double droppedSeconds = .0;
+
+		for (int id : callsites.getCallsitesTo(node->getFunctionName())) {
+			const Callsite& callsite = callsites.get(id);
+			auto caller = graph->findNode(callsite.caller);
+
+			if ((caller != nullptr && instrumentedNodes.count(caller) > 0)
+					|| callsite.inclusiveRuntimeInSeconds > runtimeThreshold) {
+				measuredCallsites.push_back(id);
+				callsiteCalls += callsite.numberOfCalls;
+			} else {
+				droppedSeconds += callsite.inclusiveRuntimeInSeconds;
+			}
+		}
+
+		// XXX a function without callsites to keep (e.g., main) stays instrumented
+		if (measuredCallsites.empty() || droppedSeconds > runtimeThreshold
+				|| callsiteCalls >= node->getNumberOfCalls()) {
+			continue;
+		}
+
+		node->setState(CgNodeState::NONE);
+		for (int id : measuredCallsites) {
+			report.instrumentedCallsites.push_back(callsites.get(id));
+		}
+		instrumentedEdgeCalls += callsiteCalls;
+
+		numberOfReplacedFunctions++;
+		savedCalls += node->getNumberOfCalls() - callsiteCalls;
+		unmeasuredSeconds += droppedSeconds;
+	}
+}
+
+void CallsiteInstrumentationEstimatorPhase::printAdditionalReport() {
+	EstimatorPhase::printAdditionalReport();
+
+	std::cout << "\t" << "replaced " << numberOfReplacedFunctions << " function probes by "
+			<< report.instrumentedCallsites.size() << " callsite probes"
+			<< " | saved calls: " << savedCalls
+			<< " | unmeasured cold callsites: " << unmeasuredSeconds << " s" << std::endl;
+	std::cout << "\t" << callsites.size() << " callsites, "
+			<< callsites.getNumberOfSplitEdges() << " call edges with more than one callsite" << std::endl;
+}
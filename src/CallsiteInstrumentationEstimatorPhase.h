@@ -0,0 +1,34 @@
+#ifndef CALLSITEINSTRUMENTATIONESTIMATORPHASE_H_
+#define CALLSITEINSTRUMENTATIONESTIMATORPHASE_H_
+
+#include "EstimatorPhase.h"
+#include "CallsiteGraph.h"
+
+/**
+ * RN: Moves the probes of the preceding phase (the RuntimeEstimatorPhase) from functions to single
+ * callsites where that is cheaper. A callsite into an instrumented function has to stay measured if
+ * its caller is instrumented or if its inclusive runtime is above the runtime threshold. The probe of
+ * the function is replaced by probes at these callsites if they have fewer calls than the function
+ * and the runtime of all other callsites together stays below the threshold, i.e., if only cold
+ * callsites lose their measurement. The callsite probes are in CgReport::instrumentedCallsites.
+ */
+class CallsiteInstrumentationEstimatorPhase : public EstimatorPhase {
+public:
+	CallsiteInstrumentationEstimatorPhase(const CallsiteGraph& callsites, double runtimeThreshold);
+	~CallsiteInstrumentationEstimatorPhase() {}
+
+	void modifyGraph(CgNodePtr mainMethod);
+
+protected:
+	void printAdditionalReport();
+
+private:
+	const CallsiteGraph& callsites;
+	double runtimeThreshold;
+
+	int numberOfReplacedFunctions;
+	unsigned long long savedCalls;
+	double unmeasuredSeconds;
+};
+
+#endif
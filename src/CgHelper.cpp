@@ -1,7 +1,93 @@
 #include "CgHelper.h"
 
+#include "Trace.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <sstream>
+
+unsigned long long CgConfig::nanosPerInstrumentedCall = 7;
+
+unsigned long long CgConfig::nanosPerUnwindSample 	= 0;
+unsigned long long CgConfig::nanosPerUnwindStep 		= 1000;
+
+unsigned long long CgConfig::nanosPerNormalProbe		= 220;
+unsigned long long CgConfig::nanosPerMPIProbe 			= 200;
+
+unsigned long long CgConfig::nanosPerSample					= 4500;	// PAPI timers
+//unsigned long long CgConfig::nanosPerSample				= 2000;	// itimers
+
+unsigned long long CgConfig::nanosPerHalfProbe 			= 105;
+
 int CgConfig::samplesPerSecond = 10000;
 
+namespace CgConfig {
+
+	static std::map<std::string, unsigned long long*> costModelKeys() {
+		return {
+			{"nanosPerInstrumentedCall", &nanosPerInstrumentedCall},
+			{"nanosPerUnwindSample", &nanosPerUnwindSample},
+			{"nanosPerUnwindStep", &nanosPerUnwindStep},
+			{"nanosPerNormalProbe", &nanosPerNormalProbe},
+			{"nanosPerMPIProbe", &nanosPerMPIProbe},
+			{"nanosPerSample", &nanosPerSample},
+			{"nanosPerHalfProbe", &nanosPerHalfProbe}
+		};
+	}
+
+	bool readCostModel(std::string filePath) {
+		std::ifstream file(filePath);
+		if (!file.is_open()) {
+			return false;
+		}
+
+		auto keys = costModelKeys();
+		std::string line;
+		while (std::getline(file, line)) {
+			if (line.empty() || line.front() == '#') {
+				continue;
+			}
+			std::istringstream lineStream(line);
+			std::string key;
+			std::string value;
+			std::string rest;
+			// RN: the value is read as string, >> into an unsigned long long takes -5 as a huge number
+			char* end = nullptr;
+			unsigned long long nanos = 0;
+			if (lineStream >> key >> value && !(lineStream >> rest) && isdigit((unsigned char) value.front())) {
+				nanos = strtoull(value.c_str(), &end, 10);
+			}
+			if (end == nullptr || *end != '\0') {
+				std::cerr << "Error in cost model " << filePath << ": can not parse \"" << line << "\"" << std::endl;
+				exit(1);
+			}
+			if (keys.find(key) == keys.end()) {
+				std::cerr << "Error in cost model " << filePath << ": unknown key " << key << std::endl;
+				exit(1);
+			}
+			*(keys[key]) = nanos;
+		}
+		return true;
+	}
+
+	static std::shared_ptr<CostModel> costModel = std::make_shared<RuleBasedCostModel>();
+
+	const CostModel& getCostModel() { return *costModel; }
+
+	void setCostModel(std::shared_ptr<CostModel> model) { costModel = model; }
+
+	bool writeCostModel(std::string filePath) {
+		std::ofstream file(filePath);
+		if (!file.is_open()) {
+			return false;
+		}
+		for (auto pair : costModelKeys()) {
+			file << pair.first << " " << *(pair.second) << std::endl;
+		}
+		return true;
+	}
+}
+
 namespace CgHelper {
 
 	/** returns true for nodes with two or more parents */
@@ -21,7 +107,7 @@ namespace CgHelper {
 			if (potentiallyMarked->isInstrumentedWitness()) {
 
 				costInNanos += potentiallyMarked->getNumberOfCalls()
-						* CgConfig::nanosPerInstrumentedCall;
+						* CgConfig::getCostModel().getNanosPerProbe(*potentiallyMarked, ProbeKind::INSTRUMENTATION);
 			}
 		}
 
@@ -48,6 +134,7 @@ namespace CgHelper {
 	/** Returns a set of all nodes from the starting node up to the instrumented nodes.
 	 *  It should not break for cycles, because cycles have to be instrumented by definition. */
 	CgNodePtrSet getInstrumentationPath(CgNodePtr start) {
+		TRACE_ZONE("CgHelper::getInstrumentationPath");
 
 		CgNodePtrSet path;	// visited nodes
 		std::queue<CgNodePtr> workQueue;
@@ -98,6 +185,7 @@ namespace CgHelper {
 	}
 
 	bool isUniquelyInstrumented(CgNodePtr conjunctionNode, CgNodePtr unInstrumentedNode, bool printErrors) {
+		TRACE_ZONE("CgHelper::isUniquelyInstrumented");
 		if ( (conjunctionNode->isInstrumentedConjunction() && conjunctionNode != unInstrumentedNode)
 				|| conjunctionNode->isUnwound()) {
 			return true;
@@ -138,6 +226,7 @@ namespace CgHelper {
 	 * Checks the instrumentation paths (node based!) above a conjunction node for intersection.
 	 * Returns the Number Of Errors ! */
 	int uniquelyInstrumentedConjunctionTest(CgNodePtr conjunctionNode, bool printErrors) {
+		TRACE_ZONE("CgHelper::uniquelyInstrumentedConjunctionTest");
 
 		int numberOfErrors = 0;
 
@@ -186,7 +275,7 @@ namespace CgHelper {
 				potentiallyInstrumented.begin(), potentiallyInstrumented.end(), 0ULL,
 				[] (unsigned long long acc, CgNodePtr node) {
 					if (node->isInstrumentedWitness()) {
-						return acc + (node->getNumberOfCalls()*CgConfig::nanosPerInstrumentedCall);
+						return acc + CgConfig::getCostModel().getInstrumentationNanos(*node);
 					}
 					return acc;
 				}
@@ -216,7 +305,7 @@ namespace CgHelper {
 				potentiallyInstrumented.begin(), potentiallyInstrumented.end(), 0ULL,
 				[] (unsigned long long acc, CgNodePtr node) {
 					if (node->isInstrumentedWitness()) {
-						return acc + (node->getNumberOfCalls()*CgConfig::nanosPerInstrumentedCall);
+						return acc + CgConfig::getCostModel().getInstrumentationNanos(*node);
 					}
 					return acc;
 				}
@@ -240,7 +329,7 @@ namespace CgHelper {
 				[] (unsigned long long acc, CgNodePtr node) {
 					bool onlyOneDependendConjunction = node->getDependentConjunctionsConst().size() == 1;
 					if (node->isInstrumentedWitness() && onlyOneDependendConjunction) {
-						return acc + (node->getNumberOfCalls()*CgConfig::nanosPerInstrumentedCall);
+						return acc + CgConfig::getCostModel().getInstrumentationNanos(*node);
 					}
 					return acc;
 				}
@@ -275,7 +364,7 @@ namespace CgHelper {
 					}
 
 					if (node->isInstrumentedWitness() && onlyOneDependendConjunction) {
-						return acc + (node->getNumberOfCalls()*CgConfig::nanosPerInstrumentedCall);
+						return acc + CgConfig::getCostModel().getInstrumentationNanos(*node);
 					}
 					return acc;
 				}
@@ -307,6 +396,7 @@ namespace CgHelper {
 
 	// Graph Stats
 	CgNodePtrSet getPotentialMarkerPositions(CgNodePtr conjunction) {
+		TRACE_ZONE("CgHelper::getPotentialMarkerPositions");
 		CgNodePtrSet potentialMarkerPositions;
 
 		if (!CgHelper::isConjunction(conjunction)) {
@@ -358,6 +448,7 @@ namespace CgHelper {
 	}
 
 	bool isOnCycle(CgNodePtr node) {
+		TRACE_ZONE("CgHelper::isOnCycle");
 		CgNodePtrSet visitedNodes;
 		std::queue<CgNodePtr> workQueue;
 		workQueue.push(node);
@@ -381,6 +472,7 @@ namespace CgHelper {
 	}
 
 	CgNodePtrSet getReachableConjunctions(CgNodePtrSet markerPositions) {
+		TRACE_ZONE("CgHelper::getReachableConjunctions");
 		CgNodePtrSet reachableConjunctions;
 
 		CgNodePtrSet visitedNodes;
@@ -412,6 +504,7 @@ namespace CgHelper {
 
 	// note: a function is reachable from itself
 	bool reachableFrom(CgNodePtr parentNode, CgNodePtr childNode) {
+		TRACE_ZONE("CgHelper::reachableFrom");
 
 		if (parentNode == childNode) {
 			return true;
@@ -494,6 +587,7 @@ namespace CgHelper {
 
 	/** Returns a set of all descendants including the starting node */
 	CgNodePtrSet getDescendants(CgNodePtr startingNode) {
+		TRACE_ZONE("CgHelper::getDescendants");
 
 		CgNodePtrSet childs;
 		std::queue<CgNodePtr> workQueue;
@@ -518,6 +612,7 @@ namespace CgHelper {
 
 	/** Returns a set of all ancestors including the startingNode */
 	CgNodePtrSet getAncestors(CgNodePtr startingNode) {
+		TRACE_ZONE("CgHelper::getAncestors");
 
 		CgNodePtrSet ancestors;
 		std::queue<CgNodePtr> workQueue;
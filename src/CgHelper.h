@@ -4,29 +4,38 @@
 
 #include <memory>
 #include <queue>
+#include <vector>
 #include <numeric>	// for std::accumulate
 #include <algorithm> 	// std::set_intersection
 
 #include <cassert>
 
 #include "CgNode.h"
+#include "CostModel.h"
 
-// TODO this numbers should be in a config file
+// RN: these are the defaults, they are overwritten by a cost-model file (see Calibration.h)
 namespace CgConfig {
-	const unsigned long long nanosPerInstrumentedCall = 7;
+	extern unsigned long long nanosPerInstrumentedCall;
 
-	const unsigned long long nanosPerUnwindSample 		= 0;
-	const unsigned long long nanosPerUnwindStep 			= 1000;
+	extern unsigned long long nanosPerUnwindSample;
+	extern unsigned long long nanosPerUnwindStep;
 
-	const unsigned long long nanosPerNormalProbe			= 220;
-	const unsigned long long nanosPerMPIProbe 				= 200;
+	extern unsigned long long nanosPerNormalProbe;
+	extern unsigned long long nanosPerMPIProbe;
 
-	const unsigned long long nanosPerSample						= 4500;	// PAPI timers
-//	const unsigned long long nanosPerSample						= 2000;	// itimers
+	extern unsigned long long nanosPerSample;
 
-	const unsigned long long nanosPerHalfProbe 				= 105;
+	extern unsigned long long nanosPerHalfProbe;
 
 	extern int samplesPerSecond;
+
+	/** reads "key value" lines with non-negative values, returns false if the file can not be opened, exits on errors */
+	bool readCostModel(std::string filePath);
+	bool writeCostModel(std::string filePath);
+
+	/** the per function probe costs, a RuleBasedCostModel with the default rules unless set */
+	const CostModel& getCostModel();
+	void setCostModel(std::shared_ptr<CostModel> model);
 }
 
 struct Config{
@@ -44,8 +53,29 @@ struct Config{
 	double fastestPhaseOvPercent	= 1e9;
 	double fastestPhaseOvSeconds 	= 1e9;
 
-	bool greedyUnwind = false;
 	std::string samplesFile = "";
+
+	std::string costModelFile = "costmodel.txt";
+	std::string outputPath = "out";
+
+	double overheadBudgetPercent = .0;	// 0 disables the OverheadBudgetEstimatorPhase
+	bool ballLarus = false;
+	bool callsites = false;	// read the callsites of the profile, see CallsiteGraph.h
+	bool contextTree = false;	// keep the calling context tree of the profile, see CallingContextTree.h
+	std::vector<std::string> planFormats;	// see PlanEmitter.h
+
+	// OptimalNodeBasedEstimatorPhase, see NodeBasedOptimumEstimatorPhase.h
+	bool nodeBasedOptimum = false;
+	int optimumThreads = 1;
+	double optimumSeconds = .0;	// 0 is no time budget
+	unsigned long long optimumSteps = 0;	// 0 is no step budget
+	std::string optimumCheckpoint = "";
+	bool optimumClusters = false;	// solve the clusters of conjunctions separately, a heuristic
+
+	// runtime threshold of the RuntimeEstimatorPhase, see RuntimeThreshold.h
+	std::string thresholdMode = "percentile";
+	double thresholdValue = 90;
+	bool thresholdExclusive = false;
 };
 
 namespace CgHelper {
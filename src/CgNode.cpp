@@ -4,14 +4,23 @@
 
 #define RENDER_DEPS 0
 
+namespace {
+  /** the entry of parentNode in the sorted numberOfCallsBy, or end if there is none */
+  template<typename Iterator>
+  Iterator findCallsBy(Iterator first, Iterator last, const CgNodePtr& parentNode) {
+    auto it = std::lower_bound(first, last, parentNode,
+        [](const std::pair<CgNodePtr, unsigned long long>& entry, const CgNodePtr& node) {
+          return std::less<CgNodePtr>()(entry.first, node);
+        });
+    return (it != last && !std::less<CgNodePtr>()(parentNode, it->first)) ? it : last;
+  }
+}
+
 CgNode::CgNode(std::string function) {
   this->functionName = function;
   this->parentNodes = CgNodePtrSet();
   this->childNodes = CgNodePtrSet();
 
-  this->spantreeParents = CgNodePtrSet();
-
-  this->line = -1;
   this->state = CgNodeState::NONE;
   this->numberOfUnwindSteps = 0;
 
@@ -23,6 +32,7 @@ CgNode::CgNode(std::string function) {
   this->uniqueCallPath = false;
 
   this->numberOfStatements = 0;
+  this->costRuleCache = 0;
 }
 
 void CgNode::addChildNode(CgNodePtr childNode) { childNodes.insert(childNode); }
@@ -36,10 +46,14 @@ void CgNode::removeChildNode(CgNodePtr childNode) {
 }
 
 void CgNode::removeParentNode(CgNodePtr parentNode) {
-  numberOfCallsBy.erase(parentNode);
+  auto it = findCallsBy(numberOfCallsBy.begin(), numberOfCallsBy.end(), parentNode);
+  if (it != numberOfCallsBy.end()) {
+    numberOfCallsBy.erase(it);
+  }
   parentNodes.erase(parentNode);
 }
 
+
 CgNodePtrSet &CgNode::getMarkerPositions() { return potentialMarkerPositions; }
 const CgNodePtrSet &CgNode::getMarkerPositionsConst() const { return potentialMarkerPositions; }
 CgNodePtrSet &CgNode::getDependentConjunctions() {
@@ -49,26 +63,36 @@ const CgNodePtrSet &CgNode::getDependentConjunctionsConst() const {
   return dependentConjunctions;
 }
 
+CgNodeColdData &CgNode::getColdData() {
+  if (!coldData) {
+    coldData.reset(new CgNodeColdData());
+  }
+  return *coldData;
+}
+
 void CgNode::addSpantreeParent(CgNodePtr parentNode) {
-  this->spantreeParents.insert(parentNode);
+  getColdData().spantreeParents.insert(parentNode);
 }
 
 bool CgNode::isSpantreeParent(CgNodePtr parentNode) {
-  return this->spantreeParents.find(parentNode) != spantreeParents.end();
+  return coldData && coldData->spantreeParents.find(parentNode) != coldData->spantreeParents.end();
 }
 
 void CgNode::reset() {
   this->state = CgNodeState::NONE;
   this->numberOfUnwindSteps = 0;
 
-  this->spantreeParents.clear();
+  if (coldData) {
+    coldData->spantreeParents.clear();
+  }
 }
 
 void CgNode::updateNodeAttributes(bool updateNumberOfSamples) {
+    updateStaticNodeAttributes();
+    updateDynamicNodeAttributes(updateNumberOfSamples);
+}
 
-    // this number will not change
-    this->numberOfCalls = getNumberOfCallsWithCurrentEdges();
-
+void CgNode::updateStaticNodeAttributes() {
     // has unique call path
     CgNodePtrSet visitedNodes;
     CgNodePtrSet parents = getParentNodes();
@@ -85,11 +109,37 @@ void CgNode::updateNodeAttributes(bool updateNumberOfSamples) {
         parents = uniqueParent->getParentNodes();
     }
     this->uniqueCallPath = (parents.size() == 0);
+}
+
+void CgNode::updateDynamicNodeAttributes(bool updateNumberOfSamples) {
+    // this number will not change
+    this->numberOfCalls = getNumberOfCallsWithCurrentEdges();
+
     if (updateNumberOfSamples) {
         updateExpectedNumberOfSamples();
     }
 }
 
+CgNodeStaticState CgNode::getStaticState() const {
+    CgNodeStaticState staticState;
+    staticState.childNodes = childNodes;
+    staticState.parentNodes = parentNodes;
+    staticState.potentialMarkerPositions = potentialMarkerPositions;
+    staticState.dependentConjunctions = dependentConjunctions;
+    staticState.uniqueCallPath = uniqueCallPath;
+    staticState.isCubeInstr = isCubeInstr;
+    return staticState;
+}
+
+void CgNode::restoreStaticState(const CgNodeStaticState& staticState) {
+    childNodes = staticState.childNodes;
+    parentNodes = staticState.parentNodes;
+    potentialMarkerPositions = staticState.potentialMarkerPositions;
+    dependentConjunctions = staticState.dependentConjunctions;
+    uniqueCallPath = staticState.uniqueCallPath;
+    isCubeInstr = staticState.isCubeInstr;
+}
+
 void CgNode::updateExpectedNumberOfSamples() {
 	// expected samples in this function (always round up)
 	this->expectedNumberOfSamples = (unsigned long long) ( (double) CgConfig::samplesPerSecond * runtimeInSeconds + 1);
@@ -164,10 +214,30 @@ const CgNodePtrSet &CgNode::getParentNodes() const { return parentNodes; }
 void CgNode::addCallData(CgNodePtr parentNode, unsigned long long calls,
                          double timeInSeconds) {
 
-  this->numberOfCallsBy[parentNode] += calls;
+  auto it = findCallsBy(numberOfCallsBy.begin(), numberOfCallsBy.end(), parentNode);
+  if (it == numberOfCallsBy.end()) {
+    it = numberOfCallsBy.insert(std::upper_bound(numberOfCallsBy.begin(), numberOfCallsBy.end(),
+        std::make_pair(parentNode, 0ULL),
+        [](const std::pair<CgNodePtr, unsigned long long>& lhs, const std::pair<CgNodePtr, unsigned long long>& rhs) {
+          return std::less<CgNodePtr>()(lhs.first, rhs.first);
+        }), std::make_pair(parentNode, 0ULL));
+  }
+  it->second += calls;
   this->runtimeInSeconds += timeInSeconds;
 }
 
+void CgNode::resetCallData() {
+  this->numberOfCallsBy.clear();
+  if (coldData) {
+    coldData->dominanceMap.clear();
+  }
+
+  this->numberOfCalls = 0;
+  this->runtimeInSeconds = 0.0;
+  this->inclusiveRuntimeInSeconds = 0.0;
+  this->expectedNumberOfSamples = 0;
+}
+
 void CgNode::setState(CgNodeState state, int numberOfUnwindSteps) {
 
 	// TODO i think this breaks something
@@ -222,15 +292,17 @@ unsigned long long CgNode::getNumberOfCalls() const { return numberOfCalls; }
 unsigned long long CgNode::getNumberOfCallsWithCurrentEdges() const {
 
   unsigned long long numberOfCalls = 0;
-  for (auto n : numberOfCallsBy) {
+  for (auto& n : numberOfCallsBy) {
     numberOfCalls += n.second;
   }
 
   return numberOfCalls;
 }
 
-unsigned long long CgNode::getNumberOfCalls(CgNodePtr parentNode) {
-  return numberOfCallsBy[parentNode];
+/** RN: find, the phases read the calls of shared nodes from several threads */
+unsigned long long CgNode::getNumberOfCalls(CgNodePtr parentNode) const {
+  auto it = findCallsBy(numberOfCallsBy.begin(), numberOfCallsBy.end(), parentNode);
+  return (it == numberOfCallsBy.end()) ? 0 : it->second;
 }
 
 double CgNode::getRuntimeInSeconds() { return runtimeInSeconds; }
@@ -260,14 +332,31 @@ void CgNode::print() {
 }
 
 void CgNode::setDominance(CgNodePtr child, double dominance) {
-  dominanceMap[child] = dominance;
+  getColdData().dominanceMap[child] = dominance;
 }
 
-double CgNode::getDominance(CgNodePtr child) { return dominanceMap[child]; }
+double CgNode::getDominance(CgNodePtr child) {
+  if (!coldData) {
+    return .0;
+  }
+  auto it = coldData->dominanceMap.find(child);
+  return (it == coldData->dominanceMap.end()) ? .0 : it->second;
+}
 
-void CgNode::setFilename(std::string filename) { this->filename = filename; }
+void CgNode::setFilename(std::string filename) {
+  if (!filename.empty() || coldData) {
+    getColdData().filename = filename;
+  }
+  costRuleCache = 0;	// the rules match the file
+}
+
+std::string CgNode::getFilename() const { return coldData ? coldData->filename : std::string(); }
 
-void CgNode::setLineNumber(int line) { this->line = line; }
+void CgNode::setLineNumber(int line) {
+  if (line > 0 || coldData) {
+    getColdData().line = line;
+  }
+}
 
 std::ostream& operator<<(std::ostream& stream, const CgNode& n) {
   stream << "\"" << n.getFunctionName() << "\"";
@@ -2,6 +2,8 @@
 #define CG_NODE_H
 
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <string>
@@ -69,6 +71,28 @@ typedef std::shared_ptr<CgNode> 		CgNodePtr;	// hopefully this typedef helps rea
 typedef std::set<CgNodePtr> 			CgNodePtrSet;
 typedef std::unordered_set<CgNodePtr> 	CgNodePtrUnorderedSet;
 
+// the profile independent part of a node, see CallgraphManager::saveStaticState()
+struct CgNodeStaticState {
+	CgNodePtrSet childNodes;
+	CgNodePtrSet parentNodes;
+	CgNodePtrSet potentialMarkerPositions;
+	CgNodePtrSet dependentConjunctions;
+	bool uniqueCallPath;
+	int isCubeInstr;
+};
+
+// RN: the rarely used data of a node, it is only allocated once something is set
+struct CgNodeColdData {
+	std::map<CgNodePtr, double> dominanceMap;
+
+	// this is possibly the dumbest way to implement a spanning tree
+	CgNodePtrSet spantreeParents;
+
+	// for later use
+	std::string filename;
+	int line = -1;
+};
+
 class CgNode {
 
 public:
@@ -81,14 +105,17 @@ public:
 	bool isSameFunction(CgNodePtr otherNode);
 
 	std::string getFunctionName() const;
+	std::string getFilename() const;
 
 	const CgNodePtrSet& getChildNodes() const;
 	const CgNodePtrSet& getParentNodes() const;
 
 	void addCallData(CgNodePtr parentNode, unsigned long long calls, double timeInSeconds);
+	/** forget everything that was read from a profile */
+	void resetCallData();
 	unsigned long long getNumberOfCalls() const;
 	unsigned long long getNumberOfCallsWithCurrentEdges() const;
-	unsigned long long getNumberOfCalls(CgNodePtr parentNode);
+	unsigned long long getNumberOfCalls(CgNodePtr parentNode) const;
 
 	void setNumberOfStatements(int numStmts);
 	int getNumberOfStatements();
@@ -123,6 +150,11 @@ public:
 	void reset();
 
 	void updateNodeAttributes(bool updateNumberOfSamples = true);
+	void updateStaticNodeAttributes();
+	void updateDynamicNodeAttributes(bool updateNumberOfSamples = true);
+
+	CgNodeStaticState getStaticState() const;
+	void restoreStaticState(const CgNodeStaticState& staticState);
 	void updateExpectedNumberOfSamples();
 	void setExpectedNumberOfSamples(unsigned long long samples);
 
@@ -138,6 +170,9 @@ public:
 	void setFilename(std::string filename);
 	void setLineNumber(int line);
 
+	/** the cost rules of the function per probe kind, resolved by the RuleBasedCostModel (see CostModel.h) */
+	std::atomic<uint64_t>& getCostRuleCache() const { return costRuleCache; }
+
 	void dumpToDot(std::ofstream& outputStream);
 
 	void print();
@@ -151,13 +186,17 @@ public:
     int isCubeInstr = 0;
 
 private:
-	std::string functionName;
+	// RN: the small members are grouped, so the node has no padding between them
 	CgNodeState state;
-
 	int numberOfUnwindSteps;
-	unsigned long long numberOfCalls;
 	int numberOfStatements;
 
+	// node attributes
+	bool uniqueCallPath;
+
+	std::string functionName;
+
+	unsigned long long numberOfCalls;
 	// note that these metrics are based on a profile and might be pessimistic
 	double runtimeInSeconds;
 	double inclusiveRuntimeInSeconds;
@@ -166,26 +205,21 @@ private:
 	CgNodePtrSet childNodes;
 	CgNodePtrSet parentNodes;
 
-	// parentNode -> number of calls by that parent
-	std::map<CgNodePtr, unsigned long long> numberOfCallsBy;
-
-	// 
-	std::map<CgNodePtr, double> dominanceMap;
+	// parentNode -> number of calls by that parent, sorted by the parent like a CgNodePtrSet.
+	// A vector takes a third of the memory of a map per edge.
+	std::vector<std::pair<CgNodePtr, unsigned long long> > numberOfCallsBy;
 
 	// if the node is a conjunction, these are the potentially instrumented nodes
 	CgNodePtrSet potentialMarkerPositions;
 	// if the node is a potential marker position, these conjunctions depend on its instrumentation
 	CgNodePtrSet dependentConjunctions;
 
-	// this is possibly the dumbest way to implement a spanning tree
-	CgNodePtrSet spantreeParents;
+	// 0 until a RuleBasedCostModel resolved a rule for the name & file of the function
+	mutable std::atomic<uint64_t> costRuleCache;
 
-	// node attributes
-	bool uniqueCallPath;
-
-	// for later use
-	std::string filename;
-	int line;
+	// spanning tree, dominance & source location, nullptr until one of them is set
+	std::unique_ptr<CgNodeColdData> coldData;
+	CgNodeColdData& getColdData();
 
 };
 
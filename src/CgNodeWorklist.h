@@ -0,0 +1,71 @@
+#ifndef CGNODEWORKLIST_H_
+#define CGNODEWORKLIST_H_
+
+#include "CgNode.h"
+
+#include <queue>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * RN: Worklist for the fixed-point iterations of the heuristics. The node with the most calls
+ * is popped first, ties are broken by name. A node is at most once in the worklist.
+ * A phase pushes the nodes around every change, so only those are examined again
+ * instead of sweeping the whole graph until nothing changes.
+ */
+class CgNodeWorklist {
+public:
+	CgNodeWorklist() {}
+
+	template<class InputIt>
+	CgNodeWorklist(InputIt first, InputIt last) {
+		for (; first != last; ++first) {
+			push(*first);
+		}
+	}
+
+	bool empty() const { return queue.empty(); }
+
+	/** false if the node is already in the worklist */
+	bool push(const CgNodePtr& node) {
+		if (!queued.insert(node.get()).second) {
+			return false;
+		}
+		queue.push(node);
+		return true;
+	}
+
+	void pushParents(const CgNodePtr& node) {
+		for (auto& parent : node->getParentNodes()) {
+			push(parent);
+		}
+	}
+
+	void pushChildren(const CgNodePtr& node) {
+		for (auto& child : node->getChildNodes()) {
+			push(child);
+		}
+	}
+
+	CgNodePtr pop() {
+		CgNodePtr node = queue.top();
+		queue.pop();
+		queued.erase(node.get());
+		return node;
+	}
+
+private:
+	struct MoreCallsFirst {
+		bool operator() (const CgNodePtr& lhs, const CgNodePtr& rhs) const {
+			if (lhs->getNumberOfCalls() != rhs->getNumberOfCalls()) {
+				return lhs->getNumberOfCalls() < rhs->getNumberOfCalls();
+			}
+			return std::greater<CgNodePtr>()(lhs, rhs);
+		}
+	};
+
+	std::priority_queue<CgNodePtr, std::vector<CgNodePtr>, MoreCallsFirst> queue;
+	std::unordered_set<const CgNode*> queued;
+};
+
+#endif
@@ -0,0 +1,62 @@
+#include "ConjunctionClusters.h"
+
+#include "UnionFind.h"
+
+#include <algorithm>
+
+ConjunctionClusters::ConjunctionClusters(const IndexedCallgraph& indexedGraph) :
+		clusterOf(indexedGraph.size(), -1) {
+
+	UnionFind dependencies(indexedGraph.size());
+	std::vector<bool> isConjunction(indexedGraph.size(), false);
+	std::vector<bool> isMarkerPosition(indexedGraph.size(), false);
+
+	for (size_t id = 0; id < indexedGraph.size(); id++) {
+		if (indexedGraph.getParents(id).size() < 2) {
+			continue;
+		}
+		isConjunction[id] = true;
+
+		for (auto& markerPosition : indexedGraph.getNode(id)->getMarkerPositionsConst()) {
+			int markerId = indexedGraph.getId(markerPosition);
+			if (markerId >= 0) {
+				isMarkerPosition[markerId] = true;
+				dependencies.unite(id, markerId);
+			}
+		}
+	}
+
+	// ids are visited in ascending order, so the id lists are sorted
+	std::vector<int> clusterOfRoot(indexedGraph.size(), -1);
+	for (size_t id = 0; id < indexedGraph.size(); id++) {
+		if (!isConjunction[id] && !isMarkerPosition[id]) {
+			continue;
+		}
+
+		int root = dependencies.find(id);
+		if (clusterOfRoot[root] < 0) {
+			clusterOfRoot[root] = clusters.size();
+			clusters.push_back(Cluster());
+		}
+		Cluster& cluster = clusters[clusterOfRoot[root]];
+		if (isConjunction[id]) {
+			cluster.conjunctions.push_back(id);
+		}
+		if (isMarkerPosition[id]) {
+			cluster.markerPositions.push_back(id);
+		}
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& lhs, const Cluster& rhs) {
+		return lhs.conjunctions.size() > rhs.conjunctions.size();
+	});
+
+	for (size_t cluster = 0; cluster < clusters.size(); cluster++) {
+		for (int id : clusters[cluster].conjunctions) {
+			clusterOf[id] = cluster;
+		}
+		for (int id : clusters[cluster].markerPositions) {
+			clusterOf[id] = cluster;
+		}
+	}
+}
@@ -0,0 +1,39 @@
+#ifndef CONJUNCTIONCLUSTERS_H_
+#define CONJUNCTIONCLUSTERS_H_
+
+#include "IndexedCallgraph.h"
+
+#include <vector>
+
+/**
+ * Groups the conjunctions of a graph into clusters of dependent conjunctions.
+ * Two conjunctions depend on each other if they share a potential marker position,
+ * dependency is transitive. The clusters are the connected components of the bipartite graph
+ * of conjunctions and their marker positions, found with one union-find pass over all marker positions.
+ * Clusters are ordered by their number of conjunctions, the largest comes first.
+ *
+ * RN: the marker positions are the ones set by CallgraphManager::finalizeGraph
+ */
+class ConjunctionClusters {
+public:
+	ConjunctionClusters(const IndexedCallgraph& indexedGraph);
+
+	size_t size() const { return clusters.size(); }
+	/** sorted ids */
+	const std::vector<int>& getConjunctions(int cluster) const { return clusters[cluster].conjunctions; }
+	/** sorted ids */
+	const std::vector<int>& getMarkerPositions(int cluster) const { return clusters[cluster].markerPositions; }
+	/** -1 if the node is neither a conjunction nor a marker position */
+	int getCluster(int id) const { return clusterOf[id]; }
+
+private:
+	struct Cluster {
+		std::vector<int> conjunctions;
+		std::vector<int> markerPositions;
+	};
+
+	std::vector<Cluster> clusters;
+	std::vector<int> clusterOf;
+};
+
+#endif
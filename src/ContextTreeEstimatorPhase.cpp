@@ -0,0 +1,101 @@
+#include "ContextTreeEstimatorPhase.h"
+
+//// CONTEXT TREE ESTIMATOR PHASE
+
+ContextTreeEstimatorPhase::ContextTreeEstimatorPhase(std::string name,
+		std::shared_ptr<const CallingContextTree> contextTree, double runtimeThreshold) :
+		EstimatorPhase(name),
+		contextTree(contextTree),
+		runtimeThreshold(runtimeThreshold),
+		numberOfHotContexts(0) {
+}
+
+std::vector<int> ContextTreeEstimatorPhase::getDepthsOfHotContexts() {
+	auto inclusiveRuntimes = contextTree->getInclusiveRuntimes();
+
+	std::vector<bool> hotContexts(contextTree->size(), false);
+	for (size_t context = 0; context < contextTree->size(); context++) {
+		if (inclusiveRuntimes[context] > runtimeThreshold) {
+			hotContexts[context] = true;
+			numberOfHotContexts++;
+		}
+	}
+
+	auto depths = contextTree->getDistinguishingDepths(hotContexts);
+	for (int depth : depths) {
+		if (depth > 0) {
+			functionsPerDepth[depth]++;
+		}
+	}
+	return depths;
+}
+
+CgNodePtr ContextTreeEstimatorPhase::findNode(int function) const {
+	return graph->findNode(contextTree->getFunctionName(function));
+}
+
+void ContextTreeEstimatorPhase::printAdditionalReport() {
+	EstimatorPhase::printAdditionalReport();
+
+	std::cout << "\t" << "hot contexts: " << numberOfHotContexts << " of " << contextTree->size()
+			<< " | functions: " << contextTree->getNumberOfFunctions() << std::endl;
+	if (!config->tinyReport) {
+		for (auto& pair : functionsPerDepth) {
+			std::cout << "\t\t" << std::setw(4) << pair.first << ": " << pair.second << " functions" << std::endl;
+		}
+	}
+}
+
+//// CONTEXT INSTRUMENTATION ESTIMATOR PHASE
+
+ContextInstrumentationEstimatorPhase::ContextInstrumentationEstimatorPhase(
+		std::shared_ptr<const CallingContextTree> contextTree, double runtimeThreshold) :
+		ContextTreeEstimatorPhase("CCTInstr", contextTree, runtimeThreshold) {
+}
+
+/**
+ * RN: if the last d functions of every path of a function are instrumented, the instrumented
+ * functions of two paths that differ in their last d functions differ as well.
+ */
+void ContextInstrumentationEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
+	auto depths = getDepthsOfHotContexts();
+
+	std::vector<int> offsets;
+	std::vector<int> contexts;
+	contextTree->getContextsPerFunction(offsets, contexts);
+
+	for (size_t function = 0; function < depths.size(); function++) {
+		if (depths[function] == 0) {
+			continue;
+		}
+		for (int functionOnPath : contextTree->getFunctionsOnPaths(function, depths[function], offsets, contexts)) {
+			auto node = findNode(functionOnPath);
+			if (node != nullptr) {
+				node->setState(CgNodeState::INSTRUMENT_WITNESS);
+			}
+		}
+	}
+}
+
+//// CONTEXT UNWIND ESTIMATOR PHASE
+
+ContextUnwindEstimatorPhase::ContextUnwindEstimatorPhase(std::shared_ptr<const CallingContextTree> contextTree,
+		double runtimeThreshold) :
+		ContextTreeEstimatorPhase("CCTUnwind", contextTree, runtimeThreshold) {
+}
+
+void ContextUnwindEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
+	auto depths = getDepthsOfHotContexts();
+
+	for (size_t function = 0; function < depths.size(); function++) {
+		auto node = (depths[function] > 0) ? findNode(function) : nullptr;
+		if (node == nullptr) {
+			continue;
+		}
+		if (depths[function] == 1) {
+			node->setState(CgNodeState::INSTRUMENT_WITNESS);
+		} else {
+			node->setState(CgNodeState::UNWIND_INSTR, depths[function] - 1);
+		}
+	}
+}
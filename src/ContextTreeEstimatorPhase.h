@@ -0,0 +1,56 @@
+#ifndef CONTEXTTREEESTIMATORPHASE_H_
+#define CONTEXTTREEESTIMATORPHASE_H_
+
+#include "EstimatorPhase.h"
+#include "CallingContextTree.h"
+
+#include <map>
+#include <memory>
+#include <vector>
+
+/**
+ * RN: Phases on the calling context tree instead of the call graph. A context is hot if its inclusive
+ * runtime is above the runtime threshold, the inclusive runtime of a context is exact, there is no
+ * overestimation by merged call paths. The call paths of a function with hot contexts have to be told
+ * apart as far as CallingContextTree::getDistinguishingDepths(), which replaces conjunctions & marker
+ * positions. The plan is set on the functions of the call graph, so the report works as for the others.
+ */
+class ContextTreeEstimatorPhase : public EstimatorPhase {
+public:
+	ContextTreeEstimatorPhase(std::string name, std::shared_ptr<const CallingContextTree> contextTree,
+			double runtimeThreshold);
+	virtual ~ContextTreeEstimatorPhase() {}
+
+protected:
+	/** the distinguishing depth per function of the tree, 0 if the function has no hot context */
+	std::vector<int> getDepthsOfHotContexts();
+	/** nullptr if the function is not in the call graph (anymore) */
+	CgNodePtr findNode(int function) const;
+
+	void printAdditionalReport();
+
+	std::shared_ptr<const CallingContextTree> contextTree;
+	double runtimeThreshold;
+
+	size_t numberOfHotContexts;
+	std::map<int, int> functionsPerDepth;
+};
+
+/** instruments all functions on the distinguishing part of the call paths of a function */
+class ContextInstrumentationEstimatorPhase : public ContextTreeEstimatorPhase {
+public:
+	ContextInstrumentationEstimatorPhase(std::shared_ptr<const CallingContextTree> contextTree,
+			double runtimeThreshold);
+
+	void modifyGraph(CgNodePtr mainMethod);
+};
+
+/** instruments the functions with hot contexts and unwinds their distinguishing part on every call */
+class ContextUnwindEstimatorPhase : public ContextTreeEstimatorPhase {
+public:
+	ContextUnwindEstimatorPhase(std::shared_ptr<const CallingContextTree> contextTree, double runtimeThreshold);
+
+	void modifyGraph(CgNodePtr mainMethod);
+};
+
+#endif
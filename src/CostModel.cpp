@@ -0,0 +1,159 @@
+#include "CostModel.h"
+#include "CgHelper.h"
+
+#include <fnmatch.h>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+unsigned long long UniformCostModel::getNanosPerProbe(const CgNode& node, ProbeKind kind) const {
+	switch (kind) {
+	case ProbeKind::UNWIND_SAMPLE:
+		return CgConfig::nanosPerUnwindSample;
+	case ProbeKind::UNWIND_STEP:
+		return CgConfig::nanosPerUnwindStep;
+	default:
+		return CgConfig::nanosPerInstrumentedCall;
+	}
+}
+
+//// RULE BASED COST MODEL
+
+namespace {
+	/** the index of a rule + 1 is stored in 16 bits, one value is left for "no rule" */
+	const size_t maxNumberOfRules = 0xfffe;
+
+	/** 0 is never used, a node without cache entry has generation 0 */
+	uint16_t getNextGeneration() {
+		static std::atomic<uint16_t> lastGeneration(0);
+		uint16_t generation = ++lastGeneration;
+		return (generation == 0) ? ++lastGeneration : generation;
+	}
+}
+
+RuleBasedCostModel::RuleBasedCostModel() :
+		generation(getNextGeneration()) {
+	const char* rules[] = {
+		// MPI calls go through the PMPI wrappers of the measurement system
+		"instr MPI_* * nanosPerMPIProbe",
+		"instr PMPI_* * nanosPerMPIProbe",
+		// outlined OpenMP regions (GCC, Clang) are entered by every thread through the runtime
+		"instr *._omp_fn.* * nanosPerNormalProbe",
+		"instr .omp_outlined.* * nanosPerNormalProbe",
+		"instr __omp_outlined__* * nanosPerNormalProbe"
+	};
+	for (auto line : rules) {
+		Rule rule;
+		parseRule(line, rule);
+		defaultRules.push_back(rule);
+	}
+}
+
+bool RuleBasedCostModel::parseRule(std::string line, Rule& rule) {
+	std::istringstream lineStream(line);
+	std::string nanos;
+	if (!(lineStream >> rule.kind >> rule.functionPattern >> rule.filePattern >> nanos)) {
+		return false;
+	}
+	if (rule.kind != "*" && rule.kind != "instr" && rule.kind != "unwindSample" && rule.kind != "unwindStep") {
+		return false;
+	}
+
+	static const std::map<std::string, const unsigned long long*> constants = {
+		{"nanosPerInstrumentedCall", &CgConfig::nanosPerInstrumentedCall},
+		{"nanosPerUnwindSample", &CgConfig::nanosPerUnwindSample},
+		{"nanosPerUnwindStep", &CgConfig::nanosPerUnwindStep},
+		{"nanosPerNormalProbe", &CgConfig::nanosPerNormalProbe},
+		{"nanosPerMPIProbe", &CgConfig::nanosPerMPIProbe}
+	};
+	// RN: constants are looked up late, a calibrated cost model may be read after the rules
+	auto constant = constants.find(nanos);
+	if (constant != constants.end()) {
+		rule.constant = constant->second;
+		rule.nanos = 0;
+		return true;
+	}
+
+	char* end = nullptr;
+	rule.nanos = strtoull(nanos.c_str(), &end, 10);
+	rule.constant = nullptr;
+	return *end == '\0';
+}
+
+bool RuleBasedCostModel::readRules(std::string filePath) {
+	std::ifstream file(filePath);
+	if (!file.is_open()) {
+		return false;
+	}
+
+	std::string line;
+	while (std::getline(file, line)) {
+		auto comment = line.find('#');
+		if (comment != std::string::npos) {
+			line.erase(comment);
+		}
+		if (line.find_first_not_of(" \t") == std::string::npos) {
+			continue;
+		}
+
+		Rule rule;
+		if (!parseRule(line, rule)) {
+			std::cerr << "Error in cost rules " << filePath << ": can not parse \"" << line << "\"" << std::endl;
+			exit(1);
+		}
+		rules.push_back(rule);
+		if (getNumberOfRules() > maxNumberOfRules) {
+			std::cerr << "Error in cost rules " << filePath << ": more than " << maxNumberOfRules << " rules" << std::endl;
+			exit(1);
+		}
+	}
+	generation = getNextGeneration();	// the cached rules of the nodes are outdated
+	return true;
+}
+
+unsigned long long RuleBasedCostModel::getNanosPerProbe(const CgNode& node, ProbeKind kind) const {
+	const int shift = 16 * ((int) kind + 1);
+
+	// RN: relaxed, a concurrent update of another kind may get lost, that kind is only searched again
+	std::atomic<uint64_t>& cache = node.getCostRuleCache();
+	uint64_t cached = cache.load(std::memory_order_relaxed);
+	if ((cached & 0xffff) != generation) {
+		cached = generation;	// resolved by another model or other rules
+	}
+
+	size_t rule = (cached >> shift) & 0xffff;
+	if (rule == 0) {
+		rule = findRule(node, kind) + 1;
+		cache.store((cached & ~(0xffffULL << shift)) | ((uint64_t) rule << shift), std::memory_order_relaxed);
+	}
+	rule--;
+
+	if (rule == getNumberOfRules()) {
+		return uniform.getNanosPerProbe(node, kind);
+	}
+	const Rule& matchingRule = (rule < rules.size()) ? rules[rule] : defaultRules[rule - rules.size()];
+	return matchingRule.constant ? *matchingRule.constant : matchingRule.nanos;
+}
+
+size_t RuleBasedCostModel::findRule(const CgNode& node, ProbeKind kind) const {
+	const char* kindName = (kind == ProbeKind::INSTRUMENTATION) ? "instr"
+			: (kind == ProbeKind::UNWIND_SAMPLE) ? "unwindSample" : "unwindStep";
+	std::string functionName = node.getFunctionName();
+	std::string filename = node.getFilename();
+
+	size_t index = 0;
+	for (auto ruleList : {&rules, &defaultRules}) {
+		for (auto& rule : *ruleList) {
+			if ((rule.kind == "*" || rule.kind == kindName)
+					&& fnmatch(rule.functionPattern.c_str(), functionName.c_str(), 0) == 0
+					&& fnmatch(rule.filePattern.c_str(), filename.c_str(), 0) == 0) {
+				return index;
+			}
+			index++;
+		}
+	}
+	return index;
+}
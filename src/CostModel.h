@@ -0,0 +1,79 @@
+#ifndef COSTMODEL_H_
+#define COSTMODEL_H_
+
+#include "CgNode.h"
+
+#include <string>
+#include <vector>
+
+enum class ProbeKind {
+	INSTRUMENTATION,	// enter and exit probe of an instrumented function
+	UNWIND_SAMPLE,
+	UNWIND_STEP
+};
+
+/**
+ * The costs of a probe in a function. The estimator phases ask the global model
+ * (CgConfig::getCostModel()) instead of using the CgConfig constants directly.
+ */
+class CostModel {
+public:
+	virtual ~CostModel() {}
+
+	virtual unsigned long long getNanosPerProbe(const CgNode& node, ProbeKind kind) const = 0;
+
+	/** the costs of instrumenting a function for all of its calls */
+	unsigned long long getInstrumentationNanos(const CgNode& node) const {
+		return node.getNumberOfCalls() * getNanosPerProbe(node, ProbeKind::INSTRUMENTATION);
+	}
+};
+
+/** the same costs for every function, taken from the CgConfig constants */
+class UniformCostModel : public CostModel {
+public:
+	unsigned long long getNanosPerProbe(const CgNode& node, ProbeKind kind) const;
+};
+
+/**
+ * RN: Rules are checked in order, the first rule that matches the kind, the function name and
+ * the file name of the function wins. Functions without a matching rule get the uniform costs.
+ * A rule file has one rule per line, '#' starts a comment:
+ *   KIND FUNCTION_PATTERN FILE_PATTERN NANOS
+ * KIND is instr, unwindSample, unwindStep or *. The patterns are shell wildcards (fnmatch).
+ * NANOS is a number or the name of a CgConfig constant, e.g., nanosPerMPIProbe.
+ * The default rules are used after the rules of a file.
+ *
+ * RN: the matching rule of a function is only searched once per probe kind and cached in the node
+ * (CgNode::getCostRuleCache()): 16 bits for the generation of the rules, which changes with every
+ * model and every file read, and 16 bits per probe kind for the index of the rule + 1 (0 if unresolved).
+ */
+class RuleBasedCostModel : public CostModel {
+public:
+	RuleBasedCostModel();
+
+	/** false if the file can not be opened, exits on malformed rules */
+	bool readRules(std::string filePath);
+
+	unsigned long long getNanosPerProbe(const CgNode& node, ProbeKind kind) const;
+
+private:
+	struct Rule {
+		std::string kind;
+		std::string functionPattern;
+		std::string filePattern;
+		unsigned long long nanos;
+		const unsigned long long* constant;		// nullptr if nanos is used
+	};
+
+	bool parseRule(std::string line, Rule& rule);
+	/** the index of the first matching rule in rules & defaultRules, getNumberOfRules() if none matches */
+	size_t findRule(const CgNode& node, ProbeKind kind) const;
+	size_t getNumberOfRules() const { return rules.size() + defaultRules.size(); }
+
+	std::vector<Rule> rules;
+	std::vector<Rule> defaultRules;
+	UniformCostModel uniform;
+	uint16_t generation;
+};
+
+#endif
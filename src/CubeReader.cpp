@@ -1,10 +1,37 @@
 #include "CubeReader.h"
+#include "RuntimeThreshold.h"
+#include "Trace.h"
+
+#include <mutex>
+
+namespace {
+	// RN: the cube library is not reentrant, batch jobs read their profiles one after another
+	std::mutex cubeMutex;
+
+	/** inclusive time per cnode id, a cnode is always defined after its parent, so its id is larger */
+	std::vector<double> getInclusiveTimes(cube::Cube& cube, const std::vector<cube::Cnode*>& cnodes,
+			cube::Metric* timeMetric, const std::vector<cube::Thread*>& threads) {
+		std::vector<double> inclusiveTimes(cnodes.size(), .0);
+		for (size_t i = cnodes.size(); i-- > 0;) {
+			auto cnode = cnodes[i];
+			for (auto thread : threads) {
+				inclusiveTimes[cnode->get_id()] += cube.get_sev(timeMetric, cnode, thread);
+			}
+			if (cnode->get_parent() != nullptr) {
+				inclusiveTimes[cnode->get_parent()->get_id()] += inclusiveTimes[cnode->get_id()];
+			}
+		}
+		return inclusiveTimes;
+	}
+}
 
 
 CallgraphManager CubeCallgraphBuilder::build(std::string filePath, Config* c) {
+	TRACE_ZONE("CubeCallgraphBuilder::build", filePath);
 
 	CallgraphManager* cg = new CallgraphManager(c);
 
+	std::lock_guard<std::mutex> lock(cubeMutex);
 	try {
 		// Create cube instance
 		cube::Cube cube;
@@ -24,10 +51,30 @@ CallgraphManager CubeCallgraphBuilder::build(std::string filePath, Config* c) {
 
 		const std::vector<cube::Thread*> threads = cube.get_thrdv();
 
+		std::vector<double> inclusiveTimes;
+		if (c->callsites) {
+			inclusiveTimes = getInclusiveTimes(cube, cnodes, timeMetric, threads);
+		}
+
+		std::vector<int> contextOfCnode(c->contextTree ? cnodes.size() : 0, -1);
+
 		for(auto cnode : cnodes){
+			// RN: the contexts are added in the order of the cnodes, so a parent is always added before its children
+			int context = -1;
+			if (c->contextTree) {
+				auto callee = cnode->get_callee();
+				int parentContext = (cnode->get_parent() == nullptr) ? -1 : contextOfCnode[cnode->get_parent()->get_id()];
+				context = cg->putContext(parentContext, c->useMangledNames ? callee->get_mangled_name() : callee->get_name());
+				contextOfCnode[cnode->get_id()] = context;
+			}
+
 			// I don't know when this happens, but it does.
 			if(cnode->get_parent() == nullptr) {
 				cg->findOrCreateNode(c->useMangledNames ? cnode->get_callee()->get_mangled_name() : cnode->get_callee()->get_name(), cube.get_sev(timeMetric, cnode, threads.at(0)));
+				for (unsigned int i = 0; context >= 0 && i < threads.size(); i++) {
+					cg->putContextCallData(context, (unsigned long long) cube.get_sev(visitsMetric, cnode, threads.at(i)),
+							cube.get_sev(timeMetric, cnode, threads.at(i)));
+				}
 				continue;
 			}
 
@@ -38,13 +85,18 @@ CallgraphManager CubeCallgraphBuilder::build(std::string filePath, Config* c) {
 			auto parentName = c->useMangledNames ? parentNode->get_mangled_name() : parentNode->get_name();
 			auto childName = c->useMangledNames ? childNode->get_mangled_name() : childNode->get_name();
 
+			unsigned long long callsiteCalls = 0;
 			for(unsigned int i = 0; i < threads.size(); i++) {
 				unsigned long long numberOfCalls = (unsigned long long) cube.get_sev(visitsMetric, cnode, threads.at(i));
 				double timeInSeconds = cube.get_sev(timeMetric, cnode, threads.at(i));
 
 				cg->putEdge(parentName, parentNode->get_mod(), parentNode->get_begn_ln(),
 						childName, numberOfCalls, timeInSeconds);
+				if (context >= 0) {
+					cg->putContextCallData(context, numberOfCalls, timeInSeconds);
+				}
 
+				callsiteCalls += numberOfCalls;
 				overallNumberOfCalls += numberOfCalls;
 				overallRuntime += timeInSeconds;
 
@@ -54,6 +106,12 @@ CallgraphManager CubeCallgraphBuilder::build(std::string filePath, Config* c) {
 					smallestFunctionName = childName;
 				}
 			}
+
+			// RN: the module & line of a cnode are the ones of its callsite
+			if (c->callsites) {
+				cg->putCallsite(parentName, childName, cnode->get_mod(), cnode->get_line(),
+						callsiteCalls, inclusiveTimes[cnode->get_id()]);
+			}
 		}
 
 		// read in samples per second TODO these are hardcoded for 10kHz
@@ -112,199 +170,14 @@ CallgraphManager CubeCallgraphBuilder::build(std::string filePath, Config* c) {
 }
 
 
-float CubeCallgraphBuilder::CalculateRuntimeThreshold(CallgraphManager *cg) {
-    int i=0;
-    Callgraph cgptr = cg->getCallgraph(cg);
-    CgNodePtrSet cgptrset = cgptr.getGraph();
-    int nodes_count = cgptrset.size();
-    float data[nodes_count];
-    //CgNodePtrSet::iterator it
-    for ( auto it = std::begin( cgptrset ); it != std::end(cgptrset ); ++it )
-    {
-        std::shared_ptr<CgNode> CgNodeptr = *it;
-        std::cout<<CgNodeptr->getFunctionName()<<"->"<<CgNodeptr->getInclusiveRuntimeInSeconds()<<"\n";
-        if(CgNodeptr->getInclusiveRuntimeInSeconds() > 0){
-            data[i++] = CgNodeptr->getInclusiveRuntimeInSeconds();
-        }
-    }
-    float ret_val = bucket_sort(data,i);
-    return ret_val;
-}
-
-/*
-
-float CubeCallgraphBuilder::CalculateRuntimeThreshold(std::string filePath, Config* c) {
-
-	CallgraphManager* cg = new CallgraphManager(c);
-
-	try {
-		// Create cube instance
-		cube::Cube cube;
-		// Read our cube file
-		cube.openCubeReport( filePath );
-		// Get the cube nodes
-		const std::vector<cube::Cnode*>& cnodes = cube.get_cnodev();
-        	int nodes_count = cnodes.size();
-        	float data[nodes_count];
-        	int j=0;
-		unsigned long long overallNumberOfCalls = 0;
-		double overallRuntime = 0.0;
-
-		double smallestFunctionInSeconds = 1e9;
-		std::string smallestFunctionName;
-		int edgesWithZeroRuntime = 0;
-
-		cube::Metric* timeMetric = cube.get_met("time");
-		cube::Metric* visitsMetric = cube.get_met("visits");
-
-		const std::vector<cube::Thread*> threads = cube.get_thrdv();
-		for(auto cnode : cnodes){
-            // I don't know when this happens, but it does.
-			if(cnode->get_parent() == nullptr) {
-				//cg->findOrCreateNode(c->useMangledNames ? cnode->get_callee()->get_mangled_name() : cnode->get_callee()->get_name(), cube.get_sev(timeMetric, cnode, threads.at(0)));
-                double timeInSeconds = cube.get_sev(timeMetric, cnode, threads[0]);
-                data[j] = timeInSeconds;
-                std::cout<<"main"<<"->"<<timeInSeconds<<"\n";
-                continue;
-			}
-            j++;
-
-			// Put the parent/child pair into our call graph
-			auto parentNode = cnode->get_parent()->get_callee();	// RN: don't trust no one. It IS the parent node
-			auto childNode = cnode->get_callee();
-			//childNode->setState(CgNodeState::INSTRUMENT_WITNESS);
-			//childNode->isCubeInstr = 1;
-			auto parentName = c->useMangledNames ? parentNode->get_mangled_name() : parentNode->get_name();
-			auto childName = c->useMangledNames ? childNode->get_mangled_name() : childNode->get_name();
-
-			for(unsigned int i = 0; i < threads.size(); i++) {
-				//unsigned long long numberOfCalls = (unsigned long long) cube.get_sev(visitsMetric, cnode, threads.at(i));
-				double timeInSeconds = cube.get_sev(timeMetric, cnode, threads.at(i));
-                		data[j] = timeInSeconds;
-                		std::cout<<childName<<"->"<<timeInSeconds<<"\n";
-				//childNode->setState(CgNodeState::INSTRUMENT_WITNESS);
-				//cg->putEdge(parentName, parentNode->get_mod(), parentNode->get_begn_ln(),
-							//childName, numberOfCalls, timeInSeconds);
-
-				//overallNumberOfCalls += numberOfCalls;
-				overallRuntime += timeInSeconds;
-
-				//double runtimePerCallInSeconds = timeInSeconds / numberOfCalls;
-				//if (runtimePerCallInSeconds < smallestFunctionInSeconds) {
-				//	smallestFunctionInSeconds = runtimePerCallInSeconds;
-				//	smallestFunctionName = childName;
-				//}
-			}
-            //data[j] = overallRuntime;
-            //std::cout<<parentName<<"->"<<overallRuntime<<"\n";
-		}
-		//std::cout<<"Cube Nodes\n"<<cube_nodes;
-		// read in samples per second TODO these are hardcoded for 10kHz
-
-
-		std::cout << "Total nodes in Cube file:"<<nodes_count<<"\n";
-        float ret_val = bucket_sort(data,nodes_count);
-		return ret_val;
-
-	} catch (const cube::RuntimeError& e) {
-		std::cout << "CubeReader failed: " << std::endl
-				  << e.get_msg() << std::endl;
-		exit(-1);
-	}
-
-}
- */
-
-float CubeCallgraphBuilder::bucket_sort(float arr[],int n) {
-    /*float minValue = data[0];
-    float maxValue = data[0];
-
-    for (int i = 1; i < count; i++)
-    {
-        if (data[i] > maxValue)
-            maxValue = data[i];
-        if (data[i] < minValue)
-            minValue = data[i];
-    }
-
-    int bucketLength = maxValue - minValue + 1;
-    std::vector<float>* bucket = new std::vector<float>[bucketLength];
-
-    for (int i = 0; i < bucketLength; i++)
-    {
-        bucket[i] = std::vector<float>();
-    }
-
-    for (int i = 0; i < count; i++)
-    {
-        bucket[data[i] - minValue].push_back(data[i]);
-    }
-
-    int k = 0;
-    for (int i = 0; i < bucketLength; i++)
-    {
-        int bucketSize = bucket[i].size();
-
-        if (bucketSize > 0)
-        {
-            for (int j = 0; j < bucketSize; j++)
-            {
-                data[k] = bucket[i][j];
-                k++;
-            }
-        }
-    }*/
-
-    float minValue = arr[0];
-    float maxValue = arr[0];
-
-    for (int i = 0; i < n; i++)
-    {
-        if (arr[i] > maxValue)
-            maxValue = arr[i];
-        if (arr[i] < minValue)
-            minValue = arr[i];
-    }
-    int bucketLength = (int)(maxValue - minValue + 1);
-    std::vector<float> b[bucketLength];
-    int bi=0;
-
-    // 2) Put array elements in different buckets
-    for (int i=0; i<n; i++)
-    {
-
-        /*if(arr[i] < 1){ bi = 0; }
-        else if(arr[i] < 2){bi=1;}
-        else if(arr[i] < 3){bi=2;}
-        else if(arr[i] < 4){bi=3;}
-        else if(arr[i] < 5){bi=4;}
-        else{bi = 5;}*/
-        int bi = (int)(arr[i] - minValue); // Index in bucket
-        b[bi].push_back(arr[i]);
-
-    }
-
-    // 3) Sort individual buckets
-    for (int i=0; i<bucketLength; i++)
-        sort(b[i].begin(), b[i].end());
-
-    int index = 0;
-    for (int i = 0; i < bucketLength; i++)
-        for (int j = 0; j < b[i].size(); j++)
-            arr[index++] = b[i][j];
-
-    int threshold_index = (90*n)/100;
-    return arr[threshold_index];
-
-
-}
-
 CallgraphManager CubeCallgraphBuilder::build_from_ipcg(std::string filePath, Config* c,CallgraphManager* cg) {
+    TRACE_ZONE("CubeCallgraphBuilder::build_from_ipcg", filePath);
 
     if(cg == NULL){
         CallgraphManager* cg = new CallgraphManager(c);
     }
 
+    std::lock_guard<std::mutex> lock(cubeMutex);
     try {
         // Create cube instance
         cube::Cube cube;
@@ -323,12 +196,31 @@ CallgraphManager CubeCallgraphBuilder::build_from_ipcg(std::string filePath, Con
         cube::Metric* visitsMetric = cube.get_met("visits");
 
         const std::vector<cube::Thread*> threads = cube.get_thrdv();
+
+        std::vector<double> inclusiveTimes;
+        if (c->callsites) {
+            inclusiveTimes = getInclusiveTimes(cube, cnodes, timeMetric, threads);
+        }
+        std::vector<int> contextOfCnode(c->contextTree ? cnodes.size() : 0, -1);
         //int cube_nodes = 0;
         for(auto cnode : cnodes){
             //cube_nodes++;
+            // RN: the contexts are added in the order of the cnodes, so a parent is always added before its children
+            int context = -1;
+            if (c->contextTree) {
+                auto callee = cnode->get_callee();
+                int parentContext = (cnode->get_parent() == nullptr) ? -1 : contextOfCnode[cnode->get_parent()->get_id()];
+                context = cg->putContext(parentContext, c->useMangledNames ? callee->get_mangled_name() : callee->get_name());
+                contextOfCnode[cnode->get_id()] = context;
+            }
+
             // I don't know when this happens, but it does.
             if(cnode->get_parent() == nullptr) {
                 cg->findOrCreateNode(c->useMangledNames ? cnode->get_callee()->get_mangled_name() : cnode->get_callee()->get_name(), cube.get_sev(timeMetric, cnode, threads.at(0)));
+                for (unsigned int i = 0; context >= 0 && i < threads.size(); i++) {
+                    cg->putContextCallData(context, (unsigned long long) cube.get_sev(visitsMetric, cnode, threads.at(i)),
+                                           cube.get_sev(timeMetric, cnode, threads.at(i)));
+                }
                 continue;
             }
 
@@ -338,13 +230,18 @@ CallgraphManager CubeCallgraphBuilder::build_from_ipcg(std::string filePath, Con
             auto parentName = c->useMangledNames ? parentNode->get_mangled_name() : parentNode->get_name();
             auto childName = c->useMangledNames ? childNode->get_mangled_name() : childNode->get_name();
 
+            unsigned long long callsiteCalls = 0;
             for(unsigned int i = 0; i < threads.size(); i++) {
                 unsigned long long numberOfCalls = (unsigned long long) cube.get_sev(visitsMetric, cnode, threads.at(i));
                 double timeInSeconds = cube.get_sev(timeMetric, cnode, threads.at(i));
 
                 cg->putEdge(parentName, parentNode->get_mod(), parentNode->get_begn_ln(),
                             childName, numberOfCalls, timeInSeconds);
+                if (context >= 0) {
+                    cg->putContextCallData(context, numberOfCalls, timeInSeconds);
+                }
 
+                callsiteCalls += numberOfCalls;
                 overallNumberOfCalls += numberOfCalls;
                 overallRuntime += timeInSeconds;
 
@@ -354,6 +251,11 @@ CallgraphManager CubeCallgraphBuilder::build_from_ipcg(std::string filePath, Con
                     smallestFunctionName = childName;
                 }
             }
+
+            if (c->callsites) {
+                cg->putCallsite(parentName, childName, cnode->get_mod(), cnode->get_line(),
+                                callsiteCalls, inclusiveTimes[cnode->get_id()]);
+            }
         }
         //std::cout<<"Cube Nodes\n"<<cube_nodes;
         // read in samples per second TODO these are hardcoded for 10kHz
@@ -1,5 +1,6 @@
 
 #include "Callgraph.h"
+#include "Trace.h"
 
 #include <string>
 #include <fstream>
@@ -23,6 +24,7 @@ namespace DOTCallgraphBuilder {
 	}
 
 	CallgraphManager build(std::string filePath, Config* c) {
+		TRACE_ZONE("DOTCallgraphBuilder::build", filePath);
 		CallgraphManager* cg = new CallgraphManager(c);
 
 		std::ifstream file(filePath);
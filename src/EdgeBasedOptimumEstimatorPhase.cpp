@@ -10,31 +10,39 @@ EdgeBasedOptimumEstimatorPhase::EdgeBasedOptimumEstimatorPhase() :
 EdgeBasedOptimumEstimatorPhase::~EdgeBasedOptimumEstimatorPhase() {
 }
 
+/**
+ * RN: Kruskal's algorithm for a maximum spanning forest of the (undirected) call graph.
+ * The calls on the spanning tree edges are not instrumented.
+ * Two paths to a conjunction can only meet again if they are connected via spanning tree edges,
+ * so an edge is skipped if its nodes already are in the same set of the union-find.
+ */
 void EdgeBasedOptimumEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
 
-	std::priority_queue<CgEdgeWithCalls, std::vector<CgEdgeWithCalls>, MoreCallsOnEdge> pq;
-	// get all edges
-	for (auto parentNode : (*graph)) {
-		for (auto childNode : parentNode->getChildNodes()) {
-			pq.push(CgEdgeWithCalls({
-				childNode->getNumberOfCalls(parentNode), childNode, parentNode
-			}));
+	IndexedCallgraph indexedGraph(*graph);
+
+	struct IndexedEdge {
+		unsigned long long calls;
+		int parent;
+		int child;
+	};
+	std::vector<IndexedEdge> edges;
+	for (size_t parent = 0; parent < indexedGraph.size(); parent++) {
+		auto parentNode = indexedGraph.getNode(parent);
+		for (int child : indexedGraph.getChildren(parent)) {
+			edges.push_back(IndexedEdge{indexedGraph.getNode(child)->getNumberOfCalls(parentNode), (int) parent, child});
 		}
 	}
 
-	while(!pq.empty()) {
+	// the most frequent edges first, stable to keep the result independent of the sort implementation
+	std::stable_sort(edges.begin(), edges.end(),
+			[](const IndexedEdge& lhs, const IndexedEdge& rhs) { return lhs.calls > rhs.calls; });
 
-		// try to insert edge with highest call count into span tree
-		auto edge = pq.top();
-		pq.pop();
-
-		if (!CgHelper::canReachSameConjunction(edge.child, edge.parent)) {
-
-			edge.child->addSpantreeParent(edge.parent);
+	UnionFind spanningForest(indexedGraph.size());
+	for (auto& edge : edges) {
+		if (spanningForest.unite(edge.parent, edge.child)) {
+			indexedGraph.getNode(edge.child)->addSpantreeParent(indexedGraph.getNode(edge.parent));
 		} else {
-
 			numberOfSkippedEdges++;
-			continue;
 		}
 	}
 
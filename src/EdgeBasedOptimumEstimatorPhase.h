@@ -3,6 +3,8 @@
 
 #include "EstimatorPhase.h"
 #include "CgHelper.h"
+#include "IndexedCallgraph.h"
+#include "UnionFind.h"
 
 #include <algorithm> // for std::set_intersection
 
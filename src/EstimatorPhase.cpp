@@ -1,6 +1,9 @@
 
 #include "EstimatorPhase.h"
 
+#include "ConjunctionClusters.h"
+#include "Trace.h"
+
 
 #define NO_DEBUG
 
@@ -10,16 +13,22 @@ EstimatorPhase::EstimatorPhase(std::string name, bool isMetaPhase) :
 		report(),	// initializes all members of report
 		name(name),
 		config(nullptr),
-		noReportRequired(isMetaPhase) {
+		noReportRequired(isMetaPhase),
+		instrumentedEdgeCalls(0) {
 }
 
 void EstimatorPhase::generateReport() {
+	TRACE_ZONE("EstimatorPhase::generateReport");
+
+	const CostModel& costModel = CgConfig::getCostModel();
+	unsigned long long instrumentationNanos = 0;
 
 	for(auto node : (*graph)) {
 
 		if(node->isInstrumented()) {
 			report.instrumentedMethods += 1;
 			report.instrumentedCalls += node->getNumberOfCalls();
+			instrumentationNanos += costModel.getInstrumentationNanos(*node);
 
 			report.instrumentedNames.insert(node->getFunctionName());
 			report.instrumentedNodes.push(node);
@@ -36,7 +45,8 @@ void EstimatorPhase::generateReport() {
 			unsigned long long unwindSteps = node->getNumberOfUnwindSteps();
 
 			unsigned long long unwindCostsNanos = unwindSamples *
-					(CgConfig::nanosPerUnwindSample + unwindSteps * CgConfig::nanosPerUnwindStep);
+					(costModel.getNanosPerProbe(*node, ProbeKind::UNWIND_SAMPLE)
+							+ unwindSteps * costModel.getNanosPerProbe(*node, ProbeKind::UNWIND_STEP));
 
 			report.unwoundNames[node->getFunctionName()] = unwindSteps;
 
@@ -51,8 +61,11 @@ void EstimatorPhase::generateReport() {
 	}
 
 	report.overallMethods = graph->size();
+	report.instrumentedCalls += instrumentedEdgeCalls;
+	// RN: edge probes are not attributed to a function
+	instrumentationNanos += instrumentedEdgeCalls * CgConfig::nanosPerInstrumentedCall;
 
-	report.instrOvSeconds = (double) report.instrumentedCalls * CgConfig::nanosPerInstrumentedCall / 1e9;
+	report.instrOvSeconds = (double) instrumentationNanos / 1e9;
 
 	if (config->referenceRuntime > .0) {
  		report.instrOvPercent = report.instrOvSeconds / config->referenceRuntime * 100;
@@ -176,24 +189,28 @@ void RemoveUnrelatedNodesEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
 	}
 
 	/* remove linear chains */
-	int oldNumChainsRemoved = 42;
-	while (numChainsRemoved != oldNumChainsRemoved) {	// iterate until no change
-		CgNodePtrQueueMostCalls pq(graph->begin(), graph->end());
-		oldNumChainsRemoved = numChainsRemoved;
+	CgNodeWorklist chainNodes(graph->begin(), graph->end());
+	while (!chainNodes.empty()) {	// iterate until no change
+		auto node = chainNodes.pop();
+		if (!graph->contains(node)) {
+			continue;	// already removed
+		}
 
-		for (auto node : Container(pq)) {
-			if (node->hasUniqueChild() && node->hasUniqueParent()) {
+		if (node->hasUniqueChild() && node->hasUniqueParent()) {
 
-				auto uniqueChild = node->getUniqueChild();
-				if (uniqueChild->hasUniqueParent() && (!CgHelper::isOnCycle(node) || node->hasUniqueChild())) {
+			auto uniqueChild = node->getUniqueChild();
+			if (uniqueChild->hasUniqueParent() && (!CgHelper::isOnCycle(node) || node->hasUniqueChild())) {
 
-					numChainsRemoved++;
+				numChainsRemoved++;
 
-					if (node->getNumberOfCalls() >= uniqueChild->getNumberOfCalls()) {
-						graph->erase(node, true);
-					} else {
-						graph->erase(uniqueChild, true);
-					}
+				auto removedNode = (node->getNumberOfCalls() >= uniqueChild->getNumberOfCalls()) ? node : uniqueChild;
+				// RN: only the rewired parents & children of the removed node can form new chains
+				CgNodePtrSet neighbors = removedNode->getParentNodes();
+				neighbors.insert(removedNode->getChildNodes().begin(), removedNode->getChildNodes().end());
+
+				graph->erase(removedNode, true);
+				for (auto& neighbor : neighbors) {
+					chainNodes.push(neighbor);
 				}
 			}
 		}
@@ -266,7 +283,9 @@ void RemoveUnrelatedNodesEstimatorPhase::printAdditionalReport() {
 GraphStatsEstimatorPhase::GraphStatsEstimatorPhase() :
 	EstimatorPhase("GraphStats", true),
 	numCyclesDetected(0),
-	numberOfConjunctions(0) {
+	numCycles(0),
+	numberOfConjunctions(0),
+	numberOfValidMarkerPositions(0) {
 }
 
 GraphStatsEstimatorPhase::~GraphStatsEstimatorPhase() {
@@ -280,10 +299,11 @@ void GraphStatsEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
 	for (auto node : (*graph)) {
 		if (CgHelper::isConjunction(node)) {
 
-			unsigned long long unwindCostsNanos = node->getNumberOfCalls() * CgConfig::nanosPerUnwindStep;
+			unsigned long long unwindCostsNanos = node->getNumberOfCalls()
+					* CgConfig::getCostModel().getNanosPerProbe(*node, ProbeKind::UNWIND_STEP);
 			unsigned long long instrCostsNanos = 0;
 			for (auto parent : node->getParentNodes()) {
-				instrCostsNanos += parent->getNumberOfCalls() * CgConfig::nanosPerInstrumentedCall;
+				instrCostsNanos += CgConfig::getCostModel().getInstrumentationNanos(*parent);
 			}
 
 			if (unwindCostsNanos < instrCostsNanos) {
@@ -304,79 +324,48 @@ void GraphStatsEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
 
 	unsigned long long nanosInstrCosts = 0;
 	for (auto notInstrNode : nodesWithRemovedInstr) {
-		nanosInstrCosts += notInstrNode->getNumberOfCalls() * CgConfig::nanosPerInstrumentedCall;
+		nanosInstrCosts += CgConfig::getCostModel().getInstrumentationNanos(*notInstrNode);
 	}
 	unsigned long long nanosUnwCosts = 0;
 	for (auto unwNode : unwoundNodes) {
-		nanosUnwCosts += unwNode->getNumberOfCalls() * CgConfig::nanosPerUnwindStep;
+		nanosUnwCosts += unwNode->getNumberOfCalls()
+				* CgConfig::getCostModel().getNanosPerProbe(*unwNode, ProbeKind::UNWIND_STEP);
 	}
 	double secondsSavedOverall = (double) (nanosInstrCosts - nanosUnwCosts) / 1e9;
 	std::cout << "overall save is: " << secondsSavedOverall << " s in " << unwoundNodes.size() << " functions " << std::endl;
 
 
-//	// detect cycles
-//	for (auto node : (*graph)) {
-//		if (CgHelper::isOnCycle(node)) {
-//			numCyclesDetected++;
-//		}
-//	}
-//
-//	// dependent conjunctions
-//	for (auto node : (*graph)) {
-//
-//		if (!CgHelper::isConjunction(node)) {
-//			continue;
-//		}
-//
-//		numberOfConjunctions++;
-//		if (hasDependencyFor(node)) {
-//			continue;
-//		}
-//
-//		CgNodePtrSet dependentConjunctions = {node};
-//		CgNodePtrSet validMarkerPositions = node->getMarkerPositions();
-//
-//		unsigned int numberOfDependentConjunctions = 0;
-//		while (numberOfDependentConjunctions != dependentConjunctions.size()) {
-//			numberOfDependentConjunctions = dependentConjunctions.size();
-//
-//			CgNodePtrSet reachableConjunctions = CgHelper::getReachableConjunctions(validMarkerPositions);
-//			for (auto depConj : dependentConjunctions) {
-//				reachableConjunctions.erase(depConj);
-//			}
-//
-//			for (auto reachableConjunction : reachableConjunctions) {
-//				CgNodePtrSet otherValidMarkerPositions = CgHelper::getPotentialMarkerPositions(reachableConjunction);
-//
-//				if (!CgHelper::setIntersect(validMarkerPositions, otherValidMarkerPositions).empty()) {
-//					dependentConjunctions.insert(reachableConjunction);
-//					validMarkerPositions.insert(otherValidMarkerPositions.begin(), otherValidMarkerPositions.end());
-//				}
-//			}
-//		}
-//
-//		///XXX
-////		if (dependentConjunctions.size() > 100) {
-////			for (auto& dep : dependentConjunctions) {
-////				graph->erase(dep, false, true);
-////			}
-////			for (auto& marker: allValidMarkerPositions) {
-////				graph->erase(marker, false, true);
-////			}
-////		}
-//
-//		dependencies.push_back(ConjunctionDependency(dependentConjunctions, validMarkerPositions));
-//		allValidMarkerPositions.insert(validMarkerPositions.begin(), validMarkerPositions.end());
-//	}
+	IndexedCallgraph indexedGraph(*graph);
+
+	// a node is on a cycle iff its SCC is cyclic
+	for (int scc = 0; scc < indexedGraph.getNumberOfSccs(); scc++) {
+		if (indexedGraph.isCyclic(scc)) {
+			numCycles++;
+			numCyclesDetected += indexedGraph.getSccMembers(scc).size();
+		}
+	}
+
+	// dependent conjunctions
+	ConjunctionClusters clusters(indexedGraph);
+	for (size_t cluster = 0; cluster < clusters.size(); cluster++) {
+		dependencies.push_back(ConjunctionDependency{clusters.getConjunctions(cluster).size(),
+				clusters.getMarkerPositions(cluster).size()});
+		numberOfConjunctions += clusters.getConjunctions(cluster).size();
+		numberOfValidMarkerPositions += clusters.getMarkerPositions(cluster).size();
+	}
 }
 
 void GraphStatsEstimatorPhase::printAdditionalReport() {
-	std::cout << "\t" << "nodes in cycles: " << numCyclesDetected << std::endl;
+	std::cout << "\t" << "nodes in cycles: " << numCyclesDetected << " (" << numCycles << " cycles)" << std::endl;
 	std::cout << "\t" << "numberOfConjunctions: " << numberOfConjunctions
-			<< " | allValidMarkerPositions: " << allValidMarkerPositions.size() << std::endl;
+			<< " | allValidMarkerPositions: " << numberOfValidMarkerPositions
+			<< " | dependencies: " << dependencies.size() << std::endl;
+	if (config->tinyReport) {
+		return;
+	}
 	for (auto dependency : dependencies) {
-		std::cout << "\t- dependentConjunctions: " << std::setw(3) << dependency.dependentConjunctions.size()
-				<< " | validMarkerPositions: " << std::setw(3) << dependency.markerPositions.size() << std::endl;
+		std::cout << "\t- dependentConjunctions: " << std::setw(3) << dependency.numberOfConjunctions
+				<< " | validMarkerPositions: " << std::setw(3) << dependency.numberOfMarkerPositions << std::endl;
 	}
 }
 
@@ -523,24 +512,17 @@ void InstrumentEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
 //// WL INSTR ESTIMATOR PHASE
 
 WLInstrEstimatorPhase::WLInstrEstimatorPhase(std::string wlFilePath) :
-		EstimatorPhase("WLInstr") {
+		EstimatorPhase("WLInstr"),
+		whiteList(false) {
 
-	std::ifstream ifStream(wlFilePath);
-	if (!ifStream.good()) {
+	if (!whiteList.readFile(wlFilePath)) {
 		std::cerr << "Error: can not find whitelist at .. " << wlFilePath << std::endl;
 	}
-
-	std::string buff;
-	while (getline(ifStream, buff)) {
-		whiteList.insert(buff);
-	}
 }
 
 void WLInstrEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
-	for (auto node : (*graph)) {
-		if (whiteList.find(node->getFunctionName()) != whiteList.end()) {
-			node->setState(CgNodeState::INSTRUMENT_WITNESS);
-		}
+	for (auto node : whiteList.getIncludedNodes(*graph)) {
+		node->setState(CgNodeState::INSTRUMENT_WITNESS);
 	}
 }
 
@@ -548,46 +530,81 @@ void WLInstrEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
 
 LibUnwindEstimatorPhase::LibUnwindEstimatorPhase(bool unwindUntilUniqueCallpath) :
 		EstimatorPhase(unwindUntilUniqueCallpath ? "unw-min" : "unw-all"),
-		currentDepth(0),
 		unwindUntilUniqueCallpath(unwindUntilUniqueCallpath) {}
 
 void LibUnwindEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
-	// find max distance from main for every function
-	for (auto child : mainMethod->getChildNodes()) {
-		visit (mainMethod, child);
+
+	IndexedCallgraph indexedGraph(*graph);
+	int numberOfSccs = indexedGraph.getNumberOfSccs();
+	int mainId = indexedGraph.getId(mainMethod);
+	if (mainId < 0) {
+		return;
 	}
-}
+	int mainScc = indexedGraph.getScc(mainId);
 
-void LibUnwindEstimatorPhase::visit(CgNodePtr from, CgNodePtr current) {
+	// callers have higher SCC ids, so all callers of an SCC are done before it
+	std::vector<bool> reachable(numberOfSccs, false);
+	std::vector<int> depth(numberOfSccs, 0);
+	reachable[mainScc] = true;
 
-	if (!(unwindUntilUniqueCallpath && current->hasUniqueCallPath())) {
-		currentDepth++;
-	}
+	for (int scc = mainScc; scc >= 0; scc--) {
+		if (!reachable[scc]) {
+			continue;
+		}
 
-	visitedEdges.insert(CgEdge(from, current));
+		int entryDepth = 0;
+		int sccSteps = 0;
+		for (int member : indexedGraph.getSccMembers(scc)) {
+			for (int parent : indexedGraph.getParents(member)) {
+				int parentScc = indexedGraph.getScc(parent);
+				if (parentScc != scc && reachable[parentScc]) {
+					entryDepth = std::max(entryDepth, depth[parentScc]);
+				}
+			}
 
-	///XXX
-//	for (auto v : visitedEdges) {
-//		std::cout << v << std::endl;
-//	}
-//	std::cout << std::endl;
+			auto node = indexedGraph.getNode(member);
+			if (member != mainId && !(unwindUntilUniqueCallpath && node->hasUniqueCallPath())) {
+				sccSteps++;
+			}
+		}
+		depth[scc] = entryDepth + sccSteps;
 
-	auto unwindSteps = current->getNumberOfUnwindSteps();
-	if (currentDepth > unwindSteps) {
-		current->setState(CgNodeState::UNWIND_SAMPLE, currentDepth);
+		for (int child : indexedGraph.getSccChildren(scc)) {
+			reachable[child] = true;
+		}
 	}
 
-	for (CgNodePtr child : current->getChildNodes()) {
-		if (visitedEdges.find(CgEdge(current, child)) == visitedEdges.end()) {
-			visit(current, child);
+	for (size_t id = 0; id < indexedGraph.size(); id++) {
+		int scc = indexedGraph.getScc(id);
+		auto node = indexedGraph.getNode(id);
+		if (!reachable[scc] || depth[scc] <= node->getNumberOfUnwindSteps()) {
+			continue;
 		}
+		node->setState(CgNodeState::UNWIND_SAMPLE, depth[scc]);
+
+		functionsPerDepth[depth[scc]]++;
+		samplesPerDepth[depth[scc]] += node->getExpectedNumberOfSamples();
 	}
+}
+
+void LibUnwindEstimatorPhase::printAdditionalReport() {
+	EstimatorPhase::printAdditionalReport();
 
-	if (config->greedyUnwind) {
-		visitedEdges.erase(CgEdge(from, current));
+	unsigned long long samples = 0;
+	unsigned long long unwindSteps = 0;
+	for (auto& pair : samplesPerDepth) {
+		samples += pair.second;
+		unwindSteps += pair.first * pair.second;
 	}
-	if (!(unwindUntilUniqueCallpath && current->hasUniqueCallPath())) {
-		currentDepth--;
+	int maxDepth = functionsPerDepth.empty() ? 0 : functionsPerDepth.rbegin()->first;
+	double meanDepth = (samples > 0) ? (double) unwindSteps / samples : .0;
+
+	std::cout << "\t" << "unwind depth: max " << maxDepth << " | mean per sample " << meanDepth << std::endl;
+	if (!config->tinyReport) {
+		for (auto& pair : functionsPerDepth) {
+			std::cout << "\t\t" << std::setw(4) << pair.first << ": " << pair.second << " functions, "
+					<< samplesPerDepth[pair.first] << " samples" << std::endl;
+		}
 	}
 }
 
@@ -603,7 +620,16 @@ MoveInstrumentationUpwardsEstimatorPhase::~MoveInstrumentationUpwardsEstimatorPh
 
 void MoveInstrumentationUpwardsEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
 
+	// the most expensive instrumentation is moved first
+	CgNodeWorklist worklist;
 	for (auto node : (*graph)) {
+		if (node->isInstrumentedWitness()) {
+			worklist.push(node);
+		}
+	}
+
+	while (!worklist.empty()) {
+		auto node = worklist.pop();
 
 		auto nextAncestor = node;
 
@@ -647,17 +673,26 @@ MinInstrHeuristicEstimatorPhase::~MinInstrHeuristicEstimatorPhase() {
 
 void MinInstrHeuristicEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
 
-	CgNodePtrQueueMostCalls pq;
+	// RN: deleting instrumentation only extends the instrumentation paths,
+	// a node that is not uniquely instrumented now would stay that way
+	for (auto node : (*graph)) {
+		if (!CgHelper::isUniquelyInstrumented(node, nullptr, false)) {
+			return;
+		}
+	}
+
+	CgNodeWorklist worklist;
 	for (auto node : (*graph)) {
 		if (node->isInstrumented()) {
-			pq.push(node);
+			worklist.push(node);
 		}
 	}
 
-	for (auto instrumentedNode : Container(pq)) {
+	while (!worklist.empty()) {
+		auto instrumentedNode = worklist.pop();
 
 		bool canDeleteInstruentation = true;
-		for (auto node : (*graph)) {
+		for (auto node : getNodesWithPathsThrough(instrumentedNode)) {
 			if (!CgHelper::isUniquelyInstrumented(node, instrumentedNode, false)) {
 				canDeleteInstruentation = false;
 				break;
@@ -670,6 +705,31 @@ void MinInstrHeuristicEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
 	}
 }
 
+/**
+ * the nodes whose instrumentation paths would pass the node if it was not instrumented,
+ * including the node itself, an instrumented conjunction is only unique by its own probe
+ */
+CgNodePtrSet MinInstrHeuristicEstimatorPhase::getNodesWithPathsThrough(CgNodePtr instrumentedNode) {
+
+	CgNodePtrSet affectedNodes = {instrumentedNode};
+	CgNodePtrSet passedNodes = {instrumentedNode};
+	std::queue<CgNodePtr> workQueue;
+	workQueue.push(instrumentedNode);
+
+	while (!workQueue.empty()) {
+		auto node = workQueue.front();
+		workQueue.pop();
+
+		for (auto child : node->getChildNodes()) {
+			affectedNodes.insert(child);
+			if (!child->isInstrumented() && passedNodes.insert(child).second) {
+				workQueue.push(child);
+			}
+		}
+	}
+	return affectedNodes;
+}
+
 void MinInstrHeuristicEstimatorPhase::printAdditionalReport() {
 	EstimatorPhase::printAdditionalReport();
 	if (!config->tinyReport) {
@@ -700,30 +760,60 @@ ConjunctionInstrumentHeuristicEstimatorPhase::~ConjunctionInstrumentHeuristicEst
 
 void ConjunctionInstrumentHeuristicEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
 
-	CgNodePtrQueueMostCalls pq(graph->begin(), graph->end());
-	for (auto node : Container(pq)) {
-
+	CgNodeWorklist worklist;
+	for (auto node : (*graph)) {
 		if (CgHelper::isConjunction(node)) {
+			worklist.push(node);
+		}
+	}
+
+	while (!worklist.empty()) {
+		auto node = worklist.pop();
 
-			unsigned long long conjInstrCosts = node->getNumberOfCalls() * CgConfig::nanosPerInstrumentedCall;
+		unsigned long long conjInstrCosts = CgConfig::getCostModel().getInstrumentationNanos(*node);
 
-			unsigned long long expectedInstrumentationOverheadNanos =
-					CgHelper::getInstrumentationOverheadOfConjunction(node);
-			unsigned long long expectedActualInstrumentationSavedNanos =
-					CgHelper::getInstrumentationOverheadServingOnlyThisConjunction(node);
-			unsigned long long witnessIntrsCostsSaved =
-					expectedInstrumentationOverheadNanos;
+		unsigned long long expectedInstrumentationOverheadNanos =
+				CgHelper::getInstrumentationOverheadOfConjunction(node);
+		unsigned long long expectedActualInstrumentationSavedNanos =
+				CgHelper::getInstrumentationOverheadServingOnlyThisConjunction(node);
+		unsigned long long witnessIntrsCostsSaved =
+				expectedInstrumentationOverheadNanos;
 //						(expectedInstrumentationOverheadNanos + expectedActualInstrumentationSavedNanos) / 2;
 
-			if (conjInstrCosts < witnessIntrsCostsSaved) {
-				node->setState(CgNodeState::INSTRUMENT_CONJUNCTION);
-			}
+		if (conjInstrCosts < witnessIntrsCostsSaved) {
+			node->setState(CgNodeState::INSTRUMENT_CONJUNCTION);
+		}
 
-			// TODO remove substituted instr
-			for (auto parentNode : node->getParentNodes()) {
-				CgHelper::deleteInstrumentationIfRedundant(parentNode);
+		// TODO remove substituted instr
+		for (auto parentNode : node->getParentNodes()) {
+			bool wasInstrumented = parentNode->isInstrumented();
+			CgHelper::deleteInstrumentationIfRedundant(parentNode);
+			if (wasInstrumented && !parentNode->isInstrumented()) {
+				pushConjunctionsBelow(worklist, parentNode);
 			}
+		}
+	}
+}
+
+/** the instrumentation paths of these conjunctions got longer, their costs changed */
+void ConjunctionInstrumentHeuristicEstimatorPhase::pushConjunctionsBelow(CgNodeWorklist& worklist, CgNodePtr node) {
+
+	CgNodePtrSet visited = {node};
+	std::queue<CgNodePtr> workQueue;
+	workQueue.push(node);
+
+	while (!workQueue.empty()) {
+		auto current = workQueue.front();
+		workQueue.pop();
 
+		for (auto child : current->getChildNodes()) {
+			if (child->isInstrumented() || !visited.insert(child).second) {
+				continue;
+			}
+			if (CgHelper::isConjunction(child)) {
+				worklist.push(child);
+			}
+			workQueue.push(child);
 		}
 	}
 }
@@ -782,22 +872,21 @@ unsigned long long UnwindEstimatorPhase::getUnwindOverheadNanos(std::map<CgNodeP
 		}
 
 		unsigned long long numSamples = pair.first->getExpectedNumberOfSamples();
-		unwindSampleOverheadNanos += numSamples * numNewUnwindSteps * CgConfig::nanosPerUnwindStep;
+		unwindSampleOverheadNanos += numSamples * numNewUnwindSteps
+				* CgConfig::getCostModel().getNanosPerProbe(*pair.first, ProbeKind::UNWIND_STEP);
 	}
 
 	return unwindSampleOverheadNanos;
 }
 
-unsigned long long UnwindEstimatorPhase::getInstrOverheadNanos(std::map<CgNodePtr, int>& unwoundNodes) {
-	std::set<CgNodePtr> keySet;
-	for (auto pair : unwoundNodes) { keySet.insert(pair.first); }
+unsigned long long UnwindEstimatorPhase::getInstrOverheadNanos(const std::vector<int>& unwoundNodes,
+		InstrumentationCostCache& costs) {
 
-	// optimistic
-	unsigned long long expectedInstrumentationOverheadNanos =
-			CgHelper::getInstrumentationOverheadOfConjunction(keySet);
-	// pessimistic
-	unsigned long long expectedActualInstrumentationSavedNanos =
-			CgHelper::getInstrumentationOverheadServingOnlyThisConjunction(keySet);
+	// optimistic & pessimistic
+	unsigned long long expectedInstrumentationOverheadNanos = 0;
+	unsigned long long expectedActualInstrumentationSavedNanos = 0;
+	costs.getOverheadOfConjunction(unwoundNodes,
+			expectedInstrumentationOverheadNanos, expectedActualInstrumentationSavedNanos);
 
 	return (expectedInstrumentationOverheadNanos + expectedActualInstrumentationSavedNanos) / 2;
 }
@@ -814,6 +903,10 @@ void UnwindEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
 		}
 	}
 
+	// RN: only node states change in this phase, so the instrumentation costs can be updated incrementally
+	IndexedCallgraph indexedGraph(*graph);
+	InstrumentationCostCache instrumentationCosts(indexedGraph);
+
 	while (!pq.empty()) {
 		auto node = pq.top();
 		pq.pop();
@@ -822,16 +915,20 @@ void UnwindEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
 
 		std::map<CgNodePtr, int> unwoundNodes;
 		getNewlyUnwoundNodes(unwoundNodes, node);
+		std::vector<int> unwoundIds;
+		for (auto pair : unwoundNodes) {
+			unwoundIds.push_back(indexedGraph.getId(pair.first));
+		}
 
 		unsigned long long unwindOverhead = getUnwindOverheadNanos(unwoundNodes);
 		if (unwindInInstr) {
-			unwindOverhead = node->getNumberOfCalls() * CgConfig::nanosPerUnwindStep;
+			unwindOverhead = node->getNumberOfCalls()
+					* CgConfig::getCostModel().getNanosPerProbe(*node, ProbeKind::UNWIND_STEP);
 		}
 
-		unsigned long long instrumentationOverhead = getInstrOverheadNanos(unwoundNodes);
+		unsigned long long instrumentationOverhead = getInstrOverheadNanos(unwoundIds, instrumentationCosts);
 		if (unwindInInstr) {
-			std::map<CgNodePtr, int> unwoundNode = {{node, 1}};
-			instrumentationOverhead = getInstrOverheadNanos(unwoundNode);
+			instrumentationOverhead = getInstrOverheadNanos({indexedGraph.getId(node)}, instrumentationCosts);
 		}
 
 		if (unwindOverhead < instrumentationOverhead) {
@@ -864,11 +961,14 @@ void UnwindEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
 			}
 
 			// remove redundant instrumentation in direct parents
+			std::vector<int> changedIds(unwoundIds);
 			for (auto pair : unwoundNodes) {
 				for (auto parentNode : pair.first->getParentNodes()) {
 					CgHelper::deleteInstrumentationIfRedundant(parentNode);
+					changedIds.push_back(indexedGraph.getId(parentNode));
 				}
 			}
+			instrumentationCosts.update(changedIds);
 
 		}
 	}
@@ -15,6 +15,10 @@
 #include "CgNode.h"
 #include "CgHelper.h"
 #include "Callgraph.h"
+#include "CgNodeWorklist.h"
+#include "CallsiteGraph.h"
+#include "FunctionFilter.h"
+#include "InstrumentationCostCache.h"
 
 struct CgReport {
 
@@ -68,6 +72,9 @@ struct CgReport {
 
 	std::map<std::string, int> unwoundNames;
 
+	// probes on single callsites instead of functions, see CallsiteInstrumentationEstimatorPhase
+	std::vector<Callsite> instrumentedCallsites;
+
 };
 
 class EstimatorPhase {
@@ -85,6 +92,8 @@ public:
 	struct CgReport getReport();
 	virtual void printReport();
 
+	std::string getName() const { return name; }
+
 	void setNoReport() { noReportRequired = true; }
 
 protected:
@@ -96,6 +105,9 @@ protected:
 	Config* config;
 	bool noReportRequired;
 
+	/* calls of probes placed on call edges instead of functions, they are added to the instrumented calls */
+	unsigned long long instrumentedEdgeCalls;
+
 	/* print some additional information of the phase */
 	virtual void printAdditionalReport();
 };
@@ -151,32 +163,21 @@ public:
 	void modifyGraph(CgNodePtr mainMethod);
 private:
 	void printAdditionalReport();
-	bool hasDependencyFor(CgNodePtr conjunction) {
-		for (auto dependency : dependencies) {
-			if (dependency.dependentConjunctions.find(conjunction) != dependency.dependentConjunctions.end()) {
-				return true;
-			}
-		}
-		return false;
-	}
 
 private:
 	struct ConjunctionDependency {
-		CgNodePtrSet dependentConjunctions;
-		CgNodePtrSet markerPositions;
-
-		ConjunctionDependency(CgNodePtrSet dependentConjunctions, CgNodePtrSet markerPositions) {
-			this->dependentConjunctions = dependentConjunctions;
-			this->markerPositions = markerPositions;
-		}
+		size_t numberOfConjunctions;
+		size_t numberOfMarkerPositions;
 	};
 
 private:
 	int numCyclesDetected;
+	int numCycles;
 
 	int numberOfConjunctions;
+	/** clusters of conjunctions that share marker positions, the largest first */
 	std::vector<ConjunctionDependency> dependencies;
-	std::set<CgNodePtr> allValidMarkerPositions;
+	size_t numberOfValidMarkerPositions;
 };
 
 class DiamondPatternSolverEstimatorPhase : public EstimatorPhase {
@@ -207,7 +208,7 @@ private:
 };
 
 /**
- * Instrument according to white list
+ * Instrument according to white list, a list of function names or a Score-P filter file
  */
 class WLInstrEstimatorPhase : public EstimatorPhase {
 public:
@@ -216,23 +217,35 @@ public:
 
 	void modifyGraph(CgNodePtr mainMethod);
 private:
-	std::set<std::string> whiteList;
+	FunctionFilter whiteList;
 };
 
 
-/** unwind in all samples until the call context is known */
+/**
+ * Unwind in all samples until the call context is known.
+ * RN: Unwinds every function reachable from main() as deep as its longest call path from main().
+ * The depths are a longest path DP over the SCC condensation, a sample in a recursion
+ * has to unwind through all functions of the SCC. Functions with a unique call path
+ * need no unwind step if unwindUntilUniqueCallpath is set.
+ */
 class LibUnwindEstimatorPhase : public EstimatorPhase {
 public:
 	LibUnwindEstimatorPhase(bool unwindUntilUniqueCallpath);
 	~LibUnwindEstimatorPhase() {}
 
 	void modifyGraph(CgNodePtr mainMethod);
-private:
-	void visit(CgNodePtr from, CgNodePtr current);
 
-	std::set<CgEdge> visitedEdges;
-	int currentDepth;
+	/** the expected samples per unwind depth */
+	const std::map<int, unsigned long long>& getSamplesPerDepth() const { return samplesPerDepth; }
+
+protected:
+	void printAdditionalReport();
+
+private:
 	bool unwindUntilUniqueCallpath;
+
+	std::map<int, int> functionsPerDepth;
+	std::map<int, unsigned long long> samplesPerDepth;
 };
 
 /**
@@ -260,6 +273,8 @@ public:
 protected:
 	void printAdditionalReport();
 private:
+	CgNodePtrSet getNodesWithPathsThrough(CgNodePtr instrumentedNode);
+
 	int deletedInstrumentationMarkers;
 };
 
@@ -283,8 +298,8 @@ public:
 	~ConjunctionInstrumentHeuristicEstimatorPhase();
 
 	void modifyGraph(CgNodePtr mainMethod);
-public:
-
+private:
+	void pushConjunctionsBelow(CgNodeWorklist& worklist, CgNodePtr node);
 };
 
 /**
@@ -302,7 +317,7 @@ private:
 	bool canBeUnwound(CgNodePtr startNode);
 
 	unsigned long long getUnwindOverheadNanos(std::map<CgNodePtr, int>& unwoundNodes);
-	unsigned long long getInstrOverheadNanos(std::map<CgNodePtr, int>& unwoundNodes);
+	unsigned long long getInstrOverheadNanos(const std::vector<int>& unwoundNodes, InstrumentationCostCache& costs);
 
 	int numUnwoundNodes;
 	int unwindCandidates;
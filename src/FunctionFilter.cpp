@@ -0,0 +1,288 @@
+#include "FunctionFilter.h"
+
+#include <cxxabi.h>
+#include <fnmatch.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+/** the longest part of a pattern without wildcards, escaped characters are literals */
+std::string getLongestLiteral(const std::string& pattern, bool& hasWildcards) {
+	std::string longest;
+	std::string current;
+	hasWildcards = false;
+
+	for (size_t i = 0; i < pattern.size(); i++) {
+		char c = pattern[i];
+		if (c == '\\' && i + 1 < pattern.size()) {
+			current += pattern[++i];
+			hasWildcards = true;	// fnmatch has to remove the escapes
+			continue;
+		}
+		if (c != '*' && c != '?' && c != '[') {
+			current += c;
+			continue;
+		}
+
+		hasWildcards = true;
+		if (c == '[') {
+			// skip the bracket expression, a ']' right after '[' or '[!' belongs to it
+			size_t end = i + 1;
+			if (end < pattern.size() && pattern[end] == '!') {
+				end++;
+			}
+			if (end < pattern.size() && pattern[end] == ']') {
+				end++;
+			}
+			end = pattern.find(']', end);
+			if (end == std::string::npos) {
+				current += c;	// fnmatch takes an unclosed '[' literally
+				continue;
+			}
+			i = end;
+		}
+		if (current.size() > longest.size()) {
+			longest = current;
+		}
+		current.clear();
+	}
+	if (current.size() > longest.size()) {
+		longest = current;
+	}
+	return longest;
+}
+
+/** empty if the name is not mangled */
+std::string demangle(const std::string& name) {
+	if (name.compare(0, 2, "_Z") != 0) {
+		return "";
+	}
+	int status = 0;
+	char* demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+	if (status != 0 || demangled == nullptr) {
+		return "";
+	}
+	std::string result(demangled);
+	free(demangled);
+	return result;
+}
+
+}
+
+//// MATCHER
+
+void FunctionFilter::Matcher::add(const std::string& pattern, int rule, bool exact) {
+	bool hasWildcards = false;
+	std::string literal = exact ? pattern : getLongestLiteral(pattern, hasWildcards);
+
+	if (!hasWildcards) {
+		exactRules[pattern] = rule;
+		return;
+	}
+
+	wildcardRules.push_back(WildcardRule{rule, pattern});
+	if (literal.empty()) {
+		alwaysCheckedRules.push_back(wildcardRules.size() - 1);
+	} else {
+		literals.add(literal);
+		literalRules.push_back(wildcardRules.size() - 1);
+	}
+}
+
+void FunctionFilter::Matcher::build() {
+	literals.build();
+}
+
+int FunctionFilter::Matcher::getLastMatchingRule(const std::string& text) const {
+	int lastRule = -1;
+	auto exact = exactRules.find(text);
+	if (exact != exactRules.end()) {
+		lastRule = exact->second;
+	}
+
+	std::vector<int> candidates(alwaysCheckedRules);
+	literals.search(text, [this, &candidates](int keyword) { candidates.push_back(literalRules[keyword]); });
+
+	// the wildcard rules are in the order of the rules, so the first match from the back is the last one
+	std::sort(candidates.begin(), candidates.end(), std::greater<int>());
+	candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+	for (int candidate : candidates) {
+		const WildcardRule& wildcardRule = wildcardRules[candidate];
+		if (wildcardRule.rule <= lastRule) {
+			break;
+		}
+		if (fnmatch(wildcardRule.pattern.c_str(), text.c_str(), 0) == 0) {
+			lastRule = wildcardRule.rule;
+			break;
+		}
+	}
+	return lastRule;
+}
+
+//// FUNCTION FILTER
+
+FunctionFilter::FunctionFilter(bool defaultIncluded) :
+		defaultIncluded(defaultIncluded) {
+	compile();
+}
+
+/** RN: a file without a SCOREP_*_BEGIN line is a plain list of function names */
+bool FunctionFilter::readFile(std::string filePath) {
+	std::ifstream file(filePath);
+	if (!file.is_open()) {
+		return false;
+	}
+
+	std::vector<std::string> lines;
+	bool isScorePFilter = false;
+	std::string line;
+	while (std::getline(file, line)) {
+		if (!line.empty() && line.back() == '\r') {
+			line.pop_back();
+		}
+		std::istringstream tokens(line);
+		std::string firstToken;
+		tokens >> firstToken;
+		isScorePFilter = isScorePFilter || firstToken == "SCOREP_REGION_NAMES_BEGIN"
+				|| firstToken == "SCOREP_FILE_NAMES_BEGIN";
+		lines.push_back(line);
+	}
+
+	if (!isScorePFilter) {
+		defaultIncluded = false;
+		for (auto& name : lines) {
+			if (!name.empty()) {
+				regionRules.push_back(Rule{true, false, true, name});
+			}
+		}
+		compile();
+		return true;
+	}
+
+	defaultIncluded = true;
+	std::vector<Rule>* section = nullptr;
+	std::string sectionEnd;
+	bool hasKind = false;
+	bool include = true;
+	bool mangled = false;
+
+	for (size_t lineNumber = 0; lineNumber < lines.size(); lineNumber++) {
+		std::string line = lines[lineNumber];
+		auto comment = line.find('#');
+		if (comment != std::string::npos) {
+			line.erase(comment);
+		}
+
+		auto error = [&filePath, lineNumber](std::string message) {
+			std::cerr << "Error in filter " << filePath << ":" << lineNumber + 1 << ": " << message << std::endl;
+			exit(1);
+		};
+
+		std::istringstream tokens(line);
+		std::string token;
+		while (tokens >> token) {
+			if (section == nullptr) {
+				if (token == "SCOREP_REGION_NAMES_BEGIN") {
+					section = &regionRules;
+					sectionEnd = "SCOREP_REGION_NAMES_END";
+				} else if (token == "SCOREP_FILE_NAMES_BEGIN") {
+					section = &fileRules;
+					sectionEnd = "SCOREP_FILE_NAMES_END";
+				} else {
+					error("\"" + token + "\" outside of a SCOREP_*_BEGIN/END block");
+				}
+				hasKind = false;
+				mangled = false;
+			} else if (token == sectionEnd) {
+				if (mangled) {
+					error("MANGLED without a pattern");
+				}
+				section = nullptr;
+			} else if (token == "INCLUDE" || token == "EXCLUDE") {
+				include = (token == "INCLUDE");
+				hasKind = true;
+			} else if (token == "MANGLED") {
+				if (section != &regionRules) {
+					error("MANGLED is only allowed for region names");
+				}
+				mangled = true;
+			} else {
+				if (!hasKind) {
+					error("pattern \"" + token + "\" before INCLUDE or EXCLUDE");
+				}
+				section->push_back(Rule{include, mangled, false, token});
+				mangled = false;
+			}
+		}
+	}
+	if (section != nullptr) {
+		std::cerr << "Error in filter " << filePath << ": missing " << sectionEnd << std::endl;
+		exit(1);
+	}
+
+	compile();
+	return true;
+}
+
+void FunctionFilter::compile() {
+	demangledMatcher = Matcher();
+	mangledMatcher = Matcher();
+	fileMatcher = Matcher();
+
+	// RN: the names of a plain list are taken as they are in the graph, mangled or not
+	for (size_t rule = 0; rule < regionRules.size(); rule++) {
+		if (regionRules[rule].exact || !regionRules[rule].mangled) {
+			demangledMatcher.add(regionRules[rule].pattern, rule, regionRules[rule].exact);
+		}
+		if (regionRules[rule].exact || regionRules[rule].mangled) {
+			mangledMatcher.add(regionRules[rule].pattern, rule, regionRules[rule].exact);
+		}
+	}
+	for (size_t rule = 0; rule < fileRules.size(); rule++) {
+		fileMatcher.add(fileRules[rule].pattern, rule, fileRules[rule].exact);
+	}
+
+	demangledMatcher.build();
+	mangledMatcher.build();
+	fileMatcher.build();
+}
+
+bool FunctionFilter::isIncluded(const std::vector<Rule>& rules, int lastMatchingRule) const {
+	return (lastMatchingRule < 0) ? defaultIncluded : rules[lastMatchingRule].include;
+}
+
+/** RN: names from the profile are usually demangled already, then MANGLED patterns see the same name */
+bool FunctionFilter::isIncluded(const CgNode& node) const {
+	std::string name = node.getFunctionName();
+	std::string demangledName = demangle(name);
+	if (demangledName.empty()) {
+		demangledName = name;
+	}
+
+	std::string filename = node.getFilename();
+	if (!filename.empty() && !fileRules.empty()) {
+		int fileRule = fileMatcher.getLastMatchingRule(filename);
+		if (fileRule >= 0 && !fileRules[fileRule].include) {
+			return false;
+		}
+	}
+
+	int rule = std::max(demangledMatcher.getLastMatchingRule(demangledName),
+			mangledMatcher.getLastMatchingRule(name));
+	return isIncluded(regionRules, rule);
+}
+
+std::vector<CgNodePtr> FunctionFilter::getIncludedNodes(const Callgraph& graph) const {
+	std::vector<CgNodePtr> includedNodes;
+	for (auto& node : graph) {
+		if (isIncluded(*node)) {
+			includedNodes.push_back(node);
+		}
+	}
+	return includedNodes;
+}
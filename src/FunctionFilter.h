@@ -0,0 +1,90 @@
+#ifndef FUNCTIONFILTER_H_
+#define FUNCTIONFILTER_H_
+
+#include "AhoCorasick.h"
+#include "Callgraph.h"
+#include "CgNode.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Decides which functions are included by a filter file, either
+ *  - a plain list with one function name per line: exactly these functions are included,
+ *    a name matches the mangled and the demangled name of a function, or
+ *  - a Score-P filter file:
+ *      SCOREP_REGION_NAMES_BEGIN
+ *        EXCLUDE *
+ *        INCLUDE main foo*
+ *                MANGLED _Z3barv
+ *      SCOREP_REGION_NAMES_END
+ *      SCOREP_FILE_NAMES_BEGIN
+ *        EXCLUDE /usr/include*
+ *      SCOREP_FILE_NAMES_END
+ *    The patterns are shell wildcards (fnmatch), '#' starts a comment. Like in Score-P the last
+ *    matching rule wins and functions without a matching rule are included. Function patterns
+ *    match the demangled name, MANGLED patterns the mangled one. A function in an excluded file
+ *    is excluded.
+ *
+ * RN: all patterns are compiled into one matcher: function names without wildcards are looked up
+ * in a hash map, the longest literal part of every wildcard pattern goes into an Aho-Corasick
+ * automaton and only the patterns whose literal occurs in a name are checked with fnmatch.
+ */
+class FunctionFilter {
+public:
+	/** white lists include nothing unless a file says otherwise */
+	FunctionFilter(bool defaultIncluded = true);
+
+	/** false if the file can not be opened, exits on malformed Score-P files */
+	bool readFile(std::string filePath);
+
+	bool isIncluded(const CgNode& node) const;
+	/** all included functions of the graph, in the order of the graph */
+	std::vector<CgNodePtr> getIncludedNodes(const Callgraph& graph) const;
+
+	size_t size() const { return regionRules.size() + fileRules.size(); }
+
+private:
+	struct Rule {
+		bool include;
+		bool mangled;
+		bool exact;	// names of a plain list may contain wildcard characters, e.g., operator*
+		std::string pattern;
+	};
+
+	/** finds the last matching rule of a set of patterns that all match the same text */
+	class Matcher {
+	public:
+		void add(const std::string& pattern, int rule, bool exact);
+		void build();
+		/** -1 if no pattern matches */
+		int getLastMatchingRule(const std::string& text) const;
+
+	private:
+		struct WildcardRule {
+			int rule;
+			std::string pattern;
+		};
+
+		std::unordered_map<std::string, int> exactRules;	// the last rule per name
+		std::vector<WildcardRule> wildcardRules;	// in the order of the rules
+		AhoCorasick literals;
+		std::vector<int> literalRules;	// the wildcard rule of every keyword of the automaton
+		std::vector<int> alwaysCheckedRules;	// wildcard rules without a literal part, e.g., "*"
+	};
+
+	void compile();
+	/** the decision of the last matching rule, defaultIncluded if none matches */
+	bool isIncluded(const std::vector<Rule>& rules, int lastMatchingRule) const;
+
+	bool defaultIncluded;
+	std::vector<Rule> regionRules;
+	std::vector<Rule> fileRules;
+
+	Matcher demangledMatcher;
+	Matcher mangledMatcher;
+	Matcher fileMatcher;
+};
+
+#endif
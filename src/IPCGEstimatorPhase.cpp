@@ -39,41 +39,28 @@ StatementCountEstimatorPhase::StatementCountEstimatorPhase(int numberOfStatement
 StatementCountEstimatorPhase::~StatementCountEstimatorPhase() {}
 
 void StatementCountEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
-	for (auto node : *graph) {
-		estimateStatementCount(node);
-	}
-}
 
-void StatementCountEstimatorPhase::estimateStatementCount(CgNodePtr startNode) {
+	IndexedCallgraph indexedGraph(*graph);
 
-	int inclStmtCount = 0;
+	std::vector<double> inclusiveStmtCounts;
 	if (inclusiveMetric) {
+		InclusiveMetricEngine engine(indexedGraph);
+		inclusiveStmtCounts = engine.compute(
+				[&indexedGraph](int id) { return indexedGraph.getNode(id)->getNumberOfStatements(); });
+	}
 
-		// INCLUSIVE
-		std::queue<CgNodePtr> workQueue;
-		workQueue.push(startNode);
-		std::set<CgNodePtr> visitedNodes;
-
-		while (!workQueue.empty()) {
-			auto node = workQueue.front();
-			workQueue.pop();
-
-			visitedNodes.insert(node);
-
-			inclStmtCount += node->getNumberOfStatements();
-
-			for (auto childNode : node->getChildNodes()) {
-				if (visitedNodes.find(childNode) == visitedNodes.end()) {
-					workQueue.push(childNode);
-				}
-			}
+	for (size_t id = 0; id < indexedGraph.size(); id++) {
+		auto node = indexedGraph.getNode(id);
+		if (inclusiveMetric) {
+			inclStmtCounts[node] = inclusiveStmtCounts[id];
+			estimateStatementCount(node, inclusiveStmtCounts[id]);
+		} else {
+			estimateStatementCount(node, node->getNumberOfStatements());
 		}
-		inclStmtCounts[startNode] = inclStmtCount;
-
-	} else {
-		// EXCLUSIVE
-		inclStmtCount = startNode->getNumberOfStatements();
 	}
+}
+
+void StatementCountEstimatorPhase::estimateStatementCount(CgNodePtr startNode, int inclStmtCount) {
 
 	if (inclStmtCount >= numberOfStatementsThreshold) {
 		startNode->setState(CgNodeState::INSTRUMENT_WITNESS);
@@ -96,47 +83,35 @@ RuntimeEstimatorPhase::RuntimeEstimatorPhase(double runTimeThreshold, bool inclu
 RuntimeEstimatorPhase::~RuntimeEstimatorPhase() {}
 
 void RuntimeEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
-    for (auto node : *graph) {
-        estimateRuntime(node);
-    }
-}
 
-void RuntimeEstimatorPhase::estimateRuntime(CgNodePtr startNode){
+    IndexedCallgraph indexedGraph(*graph);
 
-    double runTime = 0.0;
+    std::vector<double> inclusiveRunTimes;
     if (inclusiveMetric) {
-
-
-        // INCLUSIVE
-        std::queue<CgNodePtr> workQueue;
-        workQueue.push(startNode);
-        std::set<CgNodePtr> visitedNodes;
-
-        while (!workQueue.empty()) {
-            auto node = workQueue.front();
-            workQueue.pop();
-
-            visitedNodes.insert(node);
-
-            runTime += node->getInclusiveRuntimeInSeconds();
-            if(node->isCubeInstr){
-                node->setState(CgNodeState::INSTRUMENT_WITNESS);
-            }
-
-            for (auto childNode : node->getChildNodes()) {
-                if (visitedNodes.find(childNode) == visitedNodes.end()) {
-                    workQueue.push(childNode);
-                }
+        InclusiveMetricEngine engine(indexedGraph);
+        inclusiveRunTimes = engine.compute(
+                [&indexedGraph](int id) { return indexedGraph.getNode(id)->getInclusiveRuntimeInSeconds(); });
+
+        // RN: every node reaches itself, so all nodes that were instrumented by the static phases stay
+        for (size_t id = 0; id < indexedGraph.size(); id++) {
+            if (indexedGraph.getNode(id)->isCubeInstr) {
+                indexedGraph.getNode(id)->setState(CgNodeState::INSTRUMENT_WITNESS);
             }
         }
-        inclRunTime[startNode] = runTime;
-        //runTime = startNode->getInclusiveRuntimeInSeconds();
-        //inclRunTime[startNode] = runTime;
+    }
 
-    } else {
-        // EXCLUSIVE
-        runTime = startNode->getRuntimeInSeconds();
+    for (size_t id = 0; id < indexedGraph.size(); id++) {
+        auto node = indexedGraph.getNode(id);
+        if (inclusiveMetric) {
+            inclRunTime[node] = inclusiveRunTimes[id];
+            estimateRuntime(node, inclusiveRunTimes[id]);
+        } else {
+            estimateRuntime(node, node->getRuntimeInSeconds());
+        }
     }
+}
+
+void RuntimeEstimatorPhase::estimateRuntime(CgNodePtr startNode, double runTime){
 
     if (runTime > runTimeThreshold) {
                 startNode->setState(CgNodeState::INSTRUMENT_WITNESS);
@@ -172,24 +147,14 @@ WLCallpathDifferentiationEstimatorPhase::~WLCallpathDifferentiationEstimatorPhas
 
 void WLCallpathDifferentiationEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
 
-	// TODO: move this parsing somewhere else
-	std::ifstream file(whitelistName);
-	if (!file) {
+	FunctionFilter filter(false);
+	if (!filter.readFile(whitelistName)) {
 		std::cerr << "Error in WLCallpathDifferentiation: Could not open " << whitelistName << std::endl;
 		exit(1);
 	}
-	std::string line;
-	while (std::getline(file, line)) {
-		if (line.empty()) {
-			continue;
-		}
-		CgNodePtr node = graph->findNode(line);
-		if (node == nullptr) {
-			continue;
-		}
+	for (auto node : filter.getIncludedNodes(*graph)) {
 		addNodeAndParentsToWhitelist(node);
 	}
-	file.close();
 
 
 	for (auto node : *graph) {
@@ -2,6 +2,7 @@
 #define IPCGESTIMATORPHASE_H_
 
 #include "EstimatorPhase.h"
+#include "InclusiveMetricEngine.h"
 
 #include <map>
 #include <queue>
@@ -34,7 +35,7 @@ public:
 	~StatementCountEstimatorPhase();
 
 	void modifyGraph(CgNodePtr mainMethod);
-	void estimateStatementCount(CgNodePtr startNode);
+	void estimateStatementCount(CgNodePtr startNode, int inclStmtCount);
 
 private:
 	int numberOfStatementsThreshold;
@@ -48,7 +49,7 @@ public:
 	~RuntimeEstimatorPhase();
 
 	void modifyGraph(CgNodePtr mainMethod);
-	void estimateRuntime(CgNodePtr startNode);
+	void estimateRuntime(CgNodePtr startNode, double runTime);
 
 private:
     double runTimeThreshold;
@@ -57,7 +58,7 @@ private:
 };
 
 /**
- * RN: Gets a file with a whitelist of interesting nodes.
+ * RN: Gets a file with a whitelist of interesting nodes (names or a Score-P filter, see FunctionFilter).
  * Instruments all paths to these nodes with naive callpathDifferentiation.
  */
 class WLCallpathDifferentiationEstimatorPhase : public EstimatorPhase {
@@ -1,9 +1,11 @@
 #include "IPCGReader.h"
+#include "Trace.h"
 
 /** RN: note that the format is child -> parent for whatever reason.. */
-CallgraphManager IPCGAnal::build(std::string filename, Config* c) {
+IPCGAnal::IPCGFile IPCGAnal::read(std::string filename) {
+	TRACE_ZONE("IPCGAnal::read", filename);
 
-	CallgraphManager *cg = new CallgraphManager(c);
+	IPCGFile ipcgFile;
 
 	std::ifstream file(filename);
 	std::string line;
@@ -22,7 +24,7 @@ CallgraphManager IPCGAnal::build(std::string filename, Config* c) {
 				continue;
 			}
 			std::string parent = line.substr(2);
-			cg->putEdge(parent, std::string(), 0, child, 0, 0.0);
+			ipcgFile.edges.push_back(std::make_pair(parent, child));
 		} else {
 			// child
 			if (line.find("DUMMY")==0) {
@@ -38,13 +40,32 @@ CallgraphManager IPCGAnal::build(std::string filename, Config* c) {
 			}
 			else {
 				childNumStmts = std::stoi(line.substr(endPos));
-				cg->putNumberOfStatements(child, childNumStmts);
+				ipcgFile.numberOfStatements.push_back(std::make_pair(child, childNumStmts));
 			}
 				
 
 		}
 	}
 
+	return ipcgFile;
+}
+
+CallgraphManager IPCGAnal::build(std::string filename, Config* c) {
+	return build(read(filename), c);
+}
+
+CallgraphManager IPCGAnal::build(const IPCGFile& ipcgFile, Config* c) {
+	TRACE_ZONE("IPCGAnal::build");
+
+	CallgraphManager *cg = new CallgraphManager(c);
+
+	for (auto statements : ipcgFile.numberOfStatements) {
+		cg->putNumberOfStatements(statements.first, statements.second);
+	}
+	for (auto edge : ipcgFile.edges) {
+		cg->putEdge(edge.first, std::string(), 0, edge.second, 0, 0.0);
+	}
+
 	cg->printDOT("reader");
 
 	return *cg;
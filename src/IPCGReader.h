@@ -4,9 +4,20 @@
 #include "CallgraphManager.h"
 
 #include <string>
+#include <vector>
+#include <utility>
 
 namespace IPCGAnal {
+	/** the parsed content of an .ipcg file, it can be shared by several call graphs */
+	struct IPCGFile {
+		std::vector<std::pair<std::string, std::string> > edges;	// (parent, child)
+		std::vector<std::pair<std::string, int> > numberOfStatements;
+	};
+
+	IPCGFile read(std::string filepath);
+
 	CallgraphManager build(std::string filepath, Config* c);
+	CallgraphManager build(const IPCGFile& ipcgFile, Config* c);
 
 	int addRuntimeDispatchCallsFromCubexProfile(CallgraphManager &ipcg, CallgraphManager &cubecg);
 };
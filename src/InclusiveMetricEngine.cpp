@@ -0,0 +1,131 @@
+#include "InclusiveMetricEngine.h"
+
+#include <algorithm>
+
+namespace {
+/** below that many SCCs on one level the threads cost more than they save */
+const size_t minSccsPerThread = 64;
+
+size_t wordsPerScc(int firstScc, int endScc) {
+	return (endScc - firstScc + 63) / 64;
+}
+}
+
+InclusiveMetricEngine::InclusiveMetricEngine(const IndexedCallgraph& indexedGraph, int numberOfThreads,
+		int maxStoredSccs) :
+		indexedGraph(indexedGraph),
+		numberOfThreads(numberOfThreads),
+		stored(indexedGraph.getNumberOfSccs() <= maxStoredSccs),
+		sccsPerChunk(indexedGraph.getNumberOfSccs()) {
+
+	buildLevels();
+	if (stored) {
+		buildReachability(0, indexedGraph.getNumberOfSccs(), reachable);
+	} else {
+		size_t storedBits = (size_t) maxStoredSccs * maxStoredSccs;
+		sccsPerChunk = std::max<size_t>(64, storedBits / indexedGraph.getNumberOfSccs() / 64 * 64);
+	}
+}
+
+void InclusiveMetricEngine::buildLevels() {
+
+	std::vector<int> level(indexedGraph.getNumberOfSccs(), 0);
+	int numberOfLevels = 0;
+
+	// callees have lower SCC ids
+	for (int scc = 0; scc < indexedGraph.getNumberOfSccs(); scc++) {
+		for (int childScc : indexedGraph.getSccChildren(scc)) {
+			level[scc] = std::max(level[scc], level[childScc] + 1);
+		}
+		numberOfLevels = std::max(numberOfLevels, level[scc] + 1);
+	}
+
+	sccsPerLevel.assign(numberOfLevels, std::vector<int>());
+	for (int scc = 0; scc < indexedGraph.getNumberOfSccs(); scc++) {
+		sccsPerLevel[level[scc]].push_back(scc);
+	}
+}
+
+void InclusiveMetricEngine::buildReachability(int firstScc, int endScc, std::vector<uint64_t>& bits) const {
+
+	const size_t words = wordsPerScc(firstScc, endScc);
+	bits.assign(words * indexedGraph.getNumberOfSccs(), 0);
+
+	for (auto& sccs : sccsPerLevel) {
+		int threads = (sccs.size() < minSccsPerThread) ? 1 : numberOfThreads;
+		parallelFor(sccs.size(), [this, &sccs, &bits, words, firstScc, endScc](size_t i) {
+			int scc = sccs[i];
+			// RN: callees have lower ids, so no SCC of the chunk and no bit above the own one is reachable
+			if (scc < firstScc) {
+				return;
+			}
+			uint64_t* sccBits = &bits[scc * words];
+			if (scc < endScc) {
+				sccBits[(scc - firstScc) / 64] |= 1ULL << ((scc - firstScc) % 64);
+			}
+			size_t usedWords = std::min(words, (size_t) (scc - firstScc) / 64 + 1);
+
+			for (int childScc : indexedGraph.getSccChildren(scc)) {
+				if (childScc < firstScc) {
+					continue;
+				}
+				const uint64_t* childBits = &bits[childScc * words];
+				for (size_t word = 0; word < usedWords; word++) {
+					sccBits[word] |= childBits[word];
+				}
+			}
+		}, threads);
+	}
+}
+
+void InclusiveMetricEngine::addReachableValues(int firstScc, int endScc, const std::vector<uint64_t>& bits,
+		const std::vector<double>& sccValues, std::vector<double>& inclusiveSccValues) const {
+
+	const size_t words = wordsPerScc(firstScc, endScc);
+	const int numberOfSccs = indexedGraph.getNumberOfSccs();
+
+	int threads = (numberOfSccs - firstScc < (int) minSccsPerThread) ? 1 : numberOfThreads;
+	parallelFor(numberOfSccs - firstScc, [&, words, firstScc](size_t i) {
+		int scc = firstScc + i;
+		const uint64_t* sccBits = &bits[scc * words];
+		size_t usedWords = std::min(words, (size_t) (scc - firstScc) / 64 + 1);
+
+		double value = .0;
+		for (size_t word = 0; word < usedWords; word++) {
+			for (uint64_t w = sccBits[word]; w != 0; w &= w - 1) {
+				value += sccValues[firstScc + word * 64 + __builtin_ctzll(w)];
+			}
+		}
+		inclusiveSccValues[scc] += value;
+	}, threads);
+}
+
+std::vector<double> InclusiveMetricEngine::compute(std::function<double(int)> metric) const {
+
+	const int numberOfSccs = indexedGraph.getNumberOfSccs();
+
+	std::vector<double> sccValues(numberOfSccs, .0);
+	for (int scc = 0; scc < numberOfSccs; scc++) {
+		for (int member : indexedGraph.getSccMembers(scc)) {
+			sccValues[scc] += metric(member);
+		}
+	}
+
+	std::vector<double> inclusiveSccValues(numberOfSccs, .0);
+	if (stored) {
+		addReachableValues(0, numberOfSccs, reachable, sccValues, inclusiveSccValues);
+	} else {
+		std::vector<uint64_t> bits;
+		for (int firstScc = 0; firstScc < numberOfSccs; firstScc += sccsPerChunk) {
+			int endScc = std::min(numberOfSccs, firstScc + sccsPerChunk);
+			buildReachability(firstScc, endScc, bits);
+			addReachableValues(firstScc, endScc, bits, sccValues, inclusiveSccValues);
+		}
+	}
+
+	std::vector<double> inclusiveValues(indexedGraph.size());
+	for (size_t id = 0; id < indexedGraph.size(); id++) {
+		inclusiveValues[id] = inclusiveSccValues[indexedGraph.getScc(id)];
+	}
+	return inclusiveValues;
+}
@@ -0,0 +1,52 @@
+#ifndef INCLUSIVEMETRICENGINE_H_
+#define INCLUSIVEMETRICENGINE_H_
+
+#include "IndexedCallgraph.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * Computes the inclusive value of a per node metric for all nodes of a graph in one pass
+ * over the condensation, callees before callers.
+ * The inclusive value of a node is the sum over all nodes reachable from it, including itself.
+ * Every reachable node is counted once, no matter on how many paths or cycles it is reached.
+ * SCCs on the same level of the condensation (same longest distance to a leaf) are independent
+ * and are processed in parallel.
+ *
+ * RN: the sums need the reachability of every SCC as bitset, i.e., quadratic memory.
+ * Up to maxStoredSccs SCCs it is built once and used for every metric. Above, compute() builds it
+ * for one chunk of SCCs at a time, as many as fit into the memory of maxStoredSccs SCCs, which
+ * costs one pass over the condensation per chunk.
+ */
+class InclusiveMetricEngine {
+public:
+	InclusiveMetricEngine(const IndexedCallgraph& indexedGraph,
+			int numberOfThreads = ThreadPool::defaultNumberOfThreads(), int maxStoredSccs = 16384);
+
+	/** metric(id) is the exclusive value of the node with that id, the result is indexed by id */
+	std::vector<double> compute(std::function<double(int)> metric) const;
+
+	bool isStored() const { return stored; }
+
+private:
+	void buildLevels();
+	/** the bits of the SCCs firstScc to endScc - 1 reachable from every SCC */
+	void buildReachability(int firstScc, int endScc, std::vector<uint64_t>& bits) const;
+	/** adds the values of the reachable SCCs of one chunk to the inclusive values */
+	void addReachableValues(int firstScc, int endScc, const std::vector<uint64_t>& bits,
+			const std::vector<double>& sccValues, std::vector<double>& inclusiveSccValues) const;
+
+	const IndexedCallgraph& indexedGraph;
+	int numberOfThreads;
+	bool stored;
+	int sccsPerChunk;
+
+	std::vector<std::vector<int> > sccsPerLevel;
+
+	std::vector<uint64_t> reachable;	// the stored reachability of all SCCs
+};
+
+#endif
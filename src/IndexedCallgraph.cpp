@@ -0,0 +1,134 @@
+#include "IndexedCallgraph.h"
+
+#include <algorithm>
+
+IndexedCallgraph::IndexedCallgraph(Callgraph& graph) {
+	nodes.reserve(graph.size());
+	for (auto node : graph) {
+		ids[node.get()] = nodes.size();
+		nodes.push_back(node);
+	}
+
+	buildAdjacency();
+	buildCondensation();
+}
+
+int IndexedCallgraph::getId(const CgNodePtr& node) const {
+	auto it = ids.find(node.get());
+	return (it == ids.end()) ? -1 : it->second;
+}
+
+void IndexedCallgraph::buildAdjacency() {
+	childOffsets.reserve(nodes.size() + 1);
+	parentOffsets.reserve(nodes.size() + 1);
+	childOffsets.push_back(0);
+	parentOffsets.push_back(0);
+
+	for (auto& node : nodes) {
+		for (auto& child : node->getChildNodes()) {
+			int childId = getId(child);
+			if (childId >= 0) {		// RN: edges to erased nodes are ignored
+				children.push_back(childId);
+			}
+		}
+		childOffsets.push_back(children.size());
+
+		for (auto& parent : node->getParentNodes()) {
+			int parentId = getId(parent);
+			if (parentId >= 0) {
+				parents.push_back(parentId);
+			}
+		}
+		parentOffsets.push_back(parents.size());
+	}
+}
+
+/** iterative version of Tarjan's algorithm, call graphs can be too deep for recursion */
+void IndexedCallgraph::buildCondensation() {
+	const int n = nodes.size();
+
+	std::vector<int> index(n, -1);
+	std::vector<int> lowLink(n, 0);
+	std::vector<bool> onStack(n, false);
+	std::vector<int> stack;
+
+	struct Frame {
+		int id;
+		int nextChild;
+	};
+	std::vector<Frame> frames;
+
+	sccOf.assign(n, -1);
+	sccMemberOffsets.push_back(0);
+	int counter = 0;
+
+	for (int start = 0; start < n; start++) {
+		if (index[start] >= 0) {
+			continue;
+		}
+
+		index[start] = lowLink[start] = counter++;
+		stack.push_back(start);
+		onStack[start] = true;
+		frames.push_back(Frame{start, childOffsets[start]});
+
+		while (!frames.empty()) {
+			Frame& frame = frames.back();
+			int v = frame.id;
+
+			if (frame.nextChild < childOffsets[v + 1]) {
+				int w = children[frame.nextChild++];
+				if (index[w] < 0) {
+					index[w] = lowLink[w] = counter++;
+					stack.push_back(w);
+					onStack[w] = true;
+					frames.push_back(Frame{w, childOffsets[w]});	// invalidates frame
+				} else if (onStack[w]) {
+					lowLink[v] = std::min(lowLink[v], index[w]);
+				}
+				continue;
+			}
+
+			if (lowLink[v] == index[v]) {
+				int scc = sccMemberOffsets.size() - 1;
+				int w;
+				do {
+					w = stack.back();
+					stack.pop_back();
+					onStack[w] = false;
+					sccOf[w] = scc;
+					sccMembers.push_back(w);
+				} while (w != v);
+				sccMemberOffsets.push_back(sccMembers.size());
+			}
+
+			frames.pop_back();
+			if (!frames.empty()) {
+				int u = frames.back().id;
+				lowLink[u] = std::min(lowLink[u], lowLink[v]);
+			}
+		}
+	}
+
+	const int numberOfSccs = getNumberOfSccs();
+	std::vector<int> lastSeenBy(numberOfSccs, -1);
+	cyclic.assign(numberOfSccs, false);
+	sccChildOffsets.push_back(0);
+
+	for (int scc = 0; scc < numberOfSccs; scc++) {
+		cyclic[scc] = getSccMembers(scc).size() > 1;
+
+		for (int member : getSccMembers(scc)) {
+			for (int child : getChildren(member)) {
+				int childScc = sccOf[child];
+				if (childScc == scc) {
+					cyclic[scc] = true;
+				} else if (lastSeenBy[childScc] != scc) {
+					lastSeenBy[childScc] = scc;
+					sccChildren.push_back(childScc);
+				}
+			}
+		}
+		sccChildOffsets.push_back(sccChildren.size());
+	}
+}
@@ -0,0 +1,68 @@
+#ifndef INDEXEDCALLGRAPH_H_
+#define INDEXEDCALLGRAPH_H_
+
+#include "Callgraph.h"
+
+#include <unordered_map>
+#include <vector>
+
+/**
+ * A read-only snapshot of a Callgraph with dense node ids and adjacency arrays (CSR).
+ * It also holds the condensation of the graph into its strongly connected components.
+ * SCCs are numbered in reverse topological order, i.e., callees come before their callers.
+ * The snapshot gets stale as soon as the structure of the Callgraph changes.
+ */
+class IndexedCallgraph {
+public:
+	struct IdRange {
+		const int* first;
+		const int* last;
+		const int* begin() const { return first; }
+		const int* end() const { return last; }
+		size_t size() const { return last - first; }
+	};
+
+	IndexedCallgraph(Callgraph& graph);
+
+	size_t size() const { return nodes.size(); }
+	/** -1 if the node is not part of the graph */
+	int getId(const CgNodePtr& node) const;
+	const CgNodePtr& getNode(int id) const { return nodes[id]; }
+
+	IdRange getChildren(int id) const { return range(childOffsets, children, id); }
+	IdRange getParents(int id) const { return range(parentOffsets, parents, id); }
+
+	int getNumberOfSccs() const { return sccMemberOffsets.size() - 1; }
+	int getScc(int id) const { return sccOf[id]; }
+	IdRange getSccMembers(int scc) const { return range(sccMemberOffsets, sccMembers, scc); }
+	/** the distinct successors of an SCC in the condensation, without the SCC itself */
+	IdRange getSccChildren(int scc) const { return range(sccChildOffsets, sccChildren, scc); }
+	/** an SCC with more than one member or a self loop */
+	bool isCyclic(int scc) const { return cyclic[scc]; }
+
+private:
+	static IdRange range(const std::vector<int>& offsets, const std::vector<int>& values, int i) {
+		IdRange r = { values.data() + offsets[i], values.data() + offsets[i + 1] };
+		return r;
+	}
+
+	void buildAdjacency();
+	void buildCondensation();
+
+	std::vector<CgNodePtr> nodes;
+	std::unordered_map<const CgNode*, int> ids;
+
+	std::vector<int> childOffsets;
+	std::vector<int> children;
+	std::vector<int> parentOffsets;
+	std::vector<int> parents;
+
+	std::vector<int> sccOf;
+	std::vector<int> sccMemberOffsets;
+	std::vector<int> sccMembers;
+	std::vector<int> sccChildOffsets;
+	std::vector<int> sccChildren;
+	std::vector<bool> cyclic;
+};
+
+#endif
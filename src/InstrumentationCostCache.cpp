@@ -0,0 +1,130 @@
+#include "InstrumentationCostCache.h"
+#include "CgHelper.h"
+
+InstrumentationCostCache::InstrumentationCostCache(const IndexedCallgraph& indexedGraph) :
+		indexedGraph(indexedGraph),
+		witnesses(indexedGraph.size()),
+		dirty(indexedGraph.size(), true),
+		instrumented(indexedGraph.size()),
+		unwound(indexedGraph.size()),
+		unwoundDependentConjunctions(indexedGraph.size(), 0),
+		instrumentationNanos(indexedGraph.size()),
+		visitMark(indexedGraph.size(), 0),
+		currentMark(0),
+		searchMark(indexedGraph.size(), 0),
+		currentSearchMark(0) {
+
+	for (size_t id = 0; id < indexedGraph.size(); id++) {
+		auto node = indexedGraph.getNode(id);
+		instrumented[id] = node->isInstrumented();
+		unwound[id] = node->isUnwound();
+		instrumentationNanos[id] = CgConfig::getCostModel().getInstrumentationNanos(*node);
+
+		for (auto& conjunction : node->getDependentConjunctionsConst()) {
+			if (conjunction != node && conjunction->isUnwound()) {
+				unwoundDependentConjunctions[id]++;
+			}
+		}
+	}
+}
+
+void InstrumentationCostCache::getOverheadOfConjunction(const std::vector<int>& conjunctionNodes,
+		unsigned long long& overheadNanos, unsigned long long& overheadServingOnlyThisNanos) {
+
+	overheadNanos = 0;
+	overheadServingOnlyThisNanos = 0;
+
+	unsigned mark = ++currentMark;
+	for (int conjunction : conjunctionNodes) {
+		for (int parent : indexedGraph.getParents(conjunction)) {
+			for (int witness : getWitnesses(parent)) {
+				if (visitMark[witness] == mark) {
+					continue;
+				}
+				visitMark[witness] = mark;
+
+				if (indexedGraph.getNode(witness)->isInstrumentedWitness()) {
+					overheadNanos += instrumentationNanos[witness];
+					if (unwoundDependentConjunctions[witness] == 0) {
+						overheadServingOnlyThisNanos += instrumentationNanos[witness];
+					}
+				}
+			}
+		}
+	}
+}
+
+void InstrumentationCostCache::update(const std::vector<int>& changedNodes) {
+
+	for (int id : changedNodes) {
+		auto node = indexedGraph.getNode(id);
+
+		if (node->isUnwound() != unwound[id]) {
+			unwound[id] = node->isUnwound();
+			for (auto& markerPosition : node->getMarkerPositionsConst()) {
+				int markerId = indexedGraph.getId(markerPosition);
+				if (markerId >= 0 && markerId != id) {
+					unwoundDependentConjunctions[markerId] += unwound[id] ? 1 : -1;
+				}
+			}
+		}
+		if (node->isInstrumented() != instrumented[id]) {
+			instrumented[id] = node->isInstrumented();
+			invalidateBelow(id);
+		}
+	}
+}
+
+/** same search as CgHelper::getInstrumentationPath(), but only the instrumented nodes are kept */
+const std::vector<int>& InstrumentationCostCache::getWitnesses(int id) {
+
+	if (!dirty[id]) {
+		return witnesses[id];
+	}
+
+	// the mark of getOverheadOfConjunction() is still in use
+	unsigned mark = ++currentSearchMark;
+	std::vector<int> workList = {id};
+	searchMark[id] = mark;
+
+	witnesses[id].clear();
+	while (!workList.empty()) {
+		int current = workList.back();
+		workList.pop_back();
+
+		if (instrumented[current]) {
+			witnesses[id].push_back(current);
+			continue;
+		}
+		for (int parent : indexedGraph.getParents(current)) {
+			if (searchMark[parent] != mark) {
+				searchMark[parent] = mark;
+				workList.push_back(parent);
+			}
+		}
+	}
+
+	dirty[id] = false;
+	return witnesses[id];
+}
+
+/** the search of a node passes the changed node iff there is a path without instrumentation between them */
+void InstrumentationCostCache::invalidateBelow(int id) {
+
+	unsigned mark = ++currentMark;
+	std::vector<int> workList = {id};
+	visitMark[id] = mark;
+
+	while (!workList.empty()) {
+		int current = workList.back();
+		workList.pop_back();
+		dirty[current] = true;
+
+		for (int child : indexedGraph.getChildren(current)) {
+			if (visitMark[child] != mark && !instrumented[child]) {
+				visitMark[child] = mark;
+				workList.push_back(child);
+			}
+		}
+	}
+}
@@ -0,0 +1,50 @@
+#ifndef INSTRUMENTATIONCOSTCACHE_H_
+#define INSTRUMENTATIONCOSTCACHE_H_
+
+#include "IndexedCallgraph.h"
+
+#include <vector>
+
+/**
+ * RN: Incremental version of CgHelper::getInstrumentationOverheadOfConjunction() and
+ * CgHelper::getInstrumentationOverheadServingOnlyThisConjunction() for phases that only change node states.
+ * The witnesses of a node are the instrumented nodes its instrumentation path (CgHelper::getInstrumentationPath())
+ * ends at. They are cached per node and only recomputed after an instrumentation on the path changed:
+ * such a change marks all nodes below it dirty, up to the next instrumented nodes.
+ * Unwinding a conjunction is propagated to its marker positions (the only witnesses that can serve it).
+ */
+class InstrumentationCostCache {
+public:
+	InstrumentationCostCache(const IndexedCallgraph& indexedGraph);
+
+	/**
+	 * the costs of all instrumented witnesses above the parents of the nodes (optimistic), and of the ones
+	 * among them that do not serve an unwound conjunction (pessimistic)
+	 */
+	void getOverheadOfConjunction(const std::vector<int>& conjunctionNodes,
+			unsigned long long& overheadNanos, unsigned long long& overheadServingOnlyThisNanos);
+
+	/** has to be called with all nodes whose state may have changed */
+	void update(const std::vector<int>& changedNodes);
+
+private:
+	const std::vector<int>& getWitnesses(int id);
+	void invalidateBelow(int id);
+
+	const IndexedCallgraph& indexedGraph;
+
+	std::vector<std::vector<int> > witnesses;
+	std::vector<bool> dirty;
+	std::vector<bool> instrumented;		// the states the cache is valid for
+	std::vector<bool> unwound;
+	std::vector<int> unwoundDependentConjunctions;	// without the node itself
+	std::vector<unsigned long long> instrumentationNanos;
+
+	// RN: a node is visited iff its mark equals the current mark, this saves clearing a vector
+	std::vector<unsigned> visitMark;
+	unsigned currentMark;
+	std::vector<unsigned> searchMark;
+	unsigned currentSearchMark;
+};
+
+#endif
@@ -1,130 +1,733 @@
 
 #include "NodeBasedOptimumEstimatorPhase.h"
 
+#include "ConjunctionClusters.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <unordered_set>
+
 #define DEBUG 0
-#define USE_OPTIMIZED_ORDER 1	// XXX in the long term both cases should lead to the same results
 
-OptimalNodeBasedEstimatorPhase::OptimalNodeBasedEstimatorPhase() :
-		EstimatorPhase("NodeBasedOptimum"),
-		optimalCosts(INT64_MAX),
-		numberOfStepsTaken(0),
-		numberOfStepsAvoided(0) {
+//// CONSTRAINTS & STATES
+
+bool NodeBasedConstraint::validAfterExchange(int oldElement, const std::vector<int>& newElements) {
+
+	if (!std::binary_search(elements.begin(), elements.end(), oldElement)) {
+		return true;
+	}
+
+	std::vector<int> merged;
+	merged.reserve(elements.size() + newElements.size());
+
+	auto e = elements.begin();
+	auto n = newElements.begin();
+	while (e != elements.end() && n != newElements.end()) {
+		if (*e < *n) {
+			merged.push_back(*e++);
+		} else if (*n < *e) {
+			merged.push_back(*n++);
+		} else {
+			return false;	// two paths meet again
+		}
+	}
+	merged.insert(merged.end(), e, elements.end());
+	merged.insert(merged.end(), n, newElements.end());
+
+	elements.swap(merged);
+	return true;
 }
 
-OptimalNodeBasedEstimatorPhase::~OptimalNodeBasedEstimatorPhase() {
+bool NodeBasedState::validAfterExchange(int oldElement, const std::vector<int>& newElements) {
+
+	auto it = std::lower_bound(nodeSet.begin(), nodeSet.end(), oldElement);
+	if (it != nodeSet.end() && *it == oldElement) {
+		nodeSet.erase(it);
+
+		std::vector<int> merged;
+		merged.reserve(nodeSet.size() + newElements.size());
+		std::set_union(nodeSet.begin(), nodeSet.end(), newElements.begin(), newElements.end(),
+				std::back_inserter(merged));
+		nodeSet.swap(merged);
+	}
+
+	for (auto& constraint : constraints) {
+		if (!constraint.validAfterExchange(oldElement, newElements)) {
+			return false;
+		}
+	}
+	return true;
 }
 
-void OptimalNodeBasedEstimatorPhase::step(NodeBasedState& startState) {
+std::vector<int> NodeBasedState::getCanonicalEncoding() const {
+	size_t size = nodeSet.size() + 1;
+	for (auto& constraint : constraints) {
+		size += constraint.elements.size() + 1;
+	}
 
-	// skip already visited combinations
-	std::size_t hash = std::hash<NodeBasedState>()(startState);
-	if (visitedCombinations.find(hash) != visitedCombinations.end()) {
-		numberOfStepsAvoided++;
-		return;	// this combination has already been visited
+	// RN: ids are never negative, so -1 separates the sets
+	std::vector<int> encoding;
+	encoding.reserve(size);
+	encoding.insert(encoding.end(), nodeSet.begin(), nodeSet.end());
+	for (auto& constraint : constraints) {
+		encoding.push_back(-1);
+		encoding.insert(encoding.end(), constraint.elements.begin(), constraint.elements.end());
 	}
-	visitedCombinations.insert(hash);
+	return encoding;
+}
+
+//// SOLVER
 
-	numberOfStepsTaken++;
-	///XXX
-	if(numberOfStepsTaken % 10000 == 0) {
-		std::cout << numberOfStepsTaken << " steps taken ("
-				<< numberOfStepsAvoided << " avoided) " << std::endl;
+NodeBasedSolver::NodeBasedSolver(const IndexedCallgraph& indexedGraph, const std::vector<unsigned long long>& costs,
+		int numberOfThreads, double timeBudgetSeconds, unsigned long long stepBudget) :
+		numberOfStepsTaken(0),
+		numberOfStepsAvoided(0),
+		numberOfStepsPruned(0),
+		provenLowerBound(0),
+		numberOfThreads(std::max(1, numberOfThreads)),
+		timeBudgetSeconds(timeBudgetSeconds),
+		stepBudget(stepBudget),
+		costs(costs) {
+
+	parents.resize(indexedGraph.size());
+	for (size_t id = 0; id < indexedGraph.size(); id++) {
+		auto range = indexedGraph.getParents(id);
+		parents[id].assign(range.begin(), range.end());
+		std::sort(parents[id].begin(), parents[id].end());
 	}
 
-#if USE_OPTIMIZED_ORDER
-	// order the nodes by their weight, then start to replace the most expensive
-	std::priority_queue<CgNodePtr, std::vector<CgNodePtr>, CalledMoreOften> pq;
-	for (auto node : startState.nodeSet) {
-		pq.push(node);
+	// cheapest node of every SCC, then top-down over the condensation (callers have higher SCC ids)
+	std::vector<unsigned long long> sccMin(indexedGraph.getNumberOfSccs(), ULLONG_MAX);
+	for (size_t id = 0; id < indexedGraph.size(); id++) {
+		int scc = indexedGraph.getScc(id);
+		sccMin[scc] = std::min(sccMin[scc], costs[id]);
+	}
+	for (int scc = indexedGraph.getNumberOfSccs() - 1; scc >= 0; scc--) {
+		for (int childScc : indexedGraph.getSccChildren(scc)) {
+			sccMin[childScc] = std::min(sccMin[childScc], sccMin[scc]);
+		}
 	}
-	while (!pq.empty()) {
-		auto node = pq.top();
-		pq.pop();
 
-#else
-	for (auto node : startState.nodeSet) {
-#endif
+	/*
+	 * RN: a node that moves up is replaced by ALL of its parents, and the paths to one conjunction
+	 * never share a node. Outside of cycles this gives min(own costs, sum of the parents' bounds).
+	 * On cycles only the cheapest ancestor is a safe bound.
+	 */
+	minMoveCosts.resize(indexedGraph.size());
+	for (int scc = indexedGraph.getNumberOfSccs() - 1; scc >= 0; scc--) {
+		for (int id : indexedGraph.getSccMembers(scc)) {
+			if (indexedGraph.isCyclic(scc) || parents[id].empty()) {
+				minMoveCosts[id] = indexedGraph.isCyclic(scc) ? sccMin[scc] : costs[id];
+				continue;
+			}
+			unsigned long long parentCosts = 0;
+			for (int parent : parents[id]) {
+				parentCosts += minMoveCosts[parent];
+				if (parentCosts >= costs[id]) {
+					break;
+				}
+			}
+			minMoveCosts[id] = std::min(costs[id], parentCosts);
+		}
+	}
 
-		if (node->isRootNode()) {
-			continue;
+	/*
+	 * RN: main is never called, so with the bound above every node moves up for free.
+	 * Without the free nodes (costs of zero) the bound is tight again, see getLowerBound.
+	 */
+	numberOfFreeNodes = std::count(costs.begin(), costs.end(), 0ULL);
+
+	sccMin.assign(indexedGraph.getNumberOfSccs(), ULLONG_MAX);
+	for (size_t id = 0; id < indexedGraph.size(); id++) {
+		int scc = indexedGraph.getScc(id);
+		if (costs[id] > 0) {
+			sccMin[scc] = std::min(sccMin[scc], costs[id]);
 		}
+	}
+	for (int scc = indexedGraph.getNumberOfSccs() - 1; scc >= 0; scc--) {
+		for (int childScc : indexedGraph.getSccChildren(scc)) {
+			sccMin[childScc] = std::min(sccMin[childScc], sccMin[scc]);
+		}
+	}
 
-		auto parentNodes = node->getParentNodes();
-		auto newState(startState);
+	minMoveCostsWithoutFree.resize(indexedGraph.size());
+	for (int scc = indexedGraph.getNumberOfSccs() - 1; scc >= 0; scc--) {
+		for (int id : indexedGraph.getSccMembers(scc)) {
+			unsigned long long ownCosts = (costs[id] > 0) ? costs[id] : ULLONG_MAX;
+			if (indexedGraph.isCyclic(scc) || parents[id].empty()) {
+				minMoveCostsWithoutFree[id] = indexedGraph.isCyclic(scc) ? sccMin[scc] : ownCosts;
+				continue;
+			}
+			unsigned long long parentCosts = 0;
+			for (int parent : parents[id]) {
+				parentCosts += std::min(minMoveCostsWithoutFree[parent], ULLONG_MAX - parentCosts);
+				if (parentCosts >= ownCosts) {
+					break;
+				}
+			}
+			minMoveCostsWithoutFree[id] = std::min(ownCosts, parentCosts);
+		}
+	}
+}
 
-#if DEBUG
-		std::cout << "   " << "+ try switching " << *node	<< " for:  [";
-		for (auto n : parentNodes) {
-			std::cout << *n << ", ";
+unsigned long long NodeBasedSolver::getCosts(const std::vector<int>& nodeSet) const {
+	// note that the scumbag zero will break everything unless it is explicitly "ULL"
+	return std::accumulate(nodeSet.begin(), nodeSet.end(), 0ULL,
+			[this](unsigned long long sum, int id) { return sum + costs[id]; });
+}
+
+unsigned long long NodeBasedSolver::getLowerBound(const NodeBasedState& state) const {
+
+	// instrumented roots can not move
+	unsigned long long lowerBound = 0;
+	for (int id : state.nodeSet) {
+		if (parents[id].empty()) {
+			lowerBound += costs[id];
 		}
-		std::cout << "] ";
-#endif
+	}
+
+	std::vector<unsigned long long> savings;
+	for (auto& constraint : state.constraints) {
+		unsigned long long constraintBound = 0;
+		savings.clear();
+
+		auto e = constraint.elements.begin();
+		auto n = state.nodeSet.begin();
+		while (e != constraint.elements.end() && n != state.nodeSet.end()) {
+			if (*e < *n) {
+				++e;
+			} else if (*n < *e) {
+				++n;
+			} else {
+				constraintBound += minMoveCosts[*n];
+				savings.push_back(minMoveCostsWithoutFree[*n] - minMoveCosts[*n]);
+				++e;
+				++n;
+			}
+		}
+
+		// RN: each free node can only be on the paths of one element, all others pay more
+		if (savings.size() > numberOfFreeNodes) {
+			std::nth_element(savings.begin(), savings.begin() + numberOfFreeNodes, savings.end(),
+					std::greater<unsigned long long>());
+			for (auto s = savings.begin() + numberOfFreeNodes; s != savings.end(); ++s) {
+				constraintBound += std::min(*s, ULLONG_MAX - constraintBound);
+			}
+		}
+		lowerBound = std::max(lowerBound, constraintBound);
+	}
+	return lowerBound;
+}
+
+
+void NodeBasedSolver::expand(const NodeBasedState& state, std::vector<NodeBasedState>& successors) const {
+
+	for (int id : state.nodeSet) {
+		if (parents[id].empty()) {
+			continue;
+		}
+
+		NodeBasedState successor(state);
+		if (successor.validAfterExchange(id, parents[id])) {
+			successor.costs = getCosts(successor.nodeSet);
+			successors.push_back(std::move(successor));
+		}
+	}
+
+	std::sort(successors.begin(), successors.end(),
+			[](const NodeBasedState& lhs, const NodeBasedState& rhs) { return lhs.costs > rhs.costs; });
+}
+
+namespace {
+
+struct WorkDeque {
+	std::mutex mutex;
+	std::deque<NodeBasedState> states;
+};
+
+/** the visited states are spread over several sets to keep the threads from waiting for each other */
+class VisitedStates {
+public:
+	VisitedStates() : shards(64) {}
+
+	/** false if the state was visited before */
+	bool insert(std::vector<int> encoding) {
+		Shard& shard = shards[CanonicalEncodingHash()(encoding) % shards.size()];
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		return shard.encodings.insert(std::move(encoding)).second;
+	}
+
+private:
+	struct Shard {
+		std::mutex mutex;
+		std::unordered_set<std::vector<int>, CanonicalEncodingHash> encodings;
+	};
+	std::vector<Shard> shards;
+};
+
+}
+
+NodeBasedState NodeBasedSolver::solve(NodeBasedState bestState, std::vector<NodeBasedState>& openStates) {
+	return solve(bestState, openStates, numberOfThreads, std::chrono::steady_clock::now(), provenLowerBound);
+}
+
+NodeBasedState NodeBasedSolver::solve(NodeBasedState bestState, std::vector<NodeBasedState>& openStates,
+		int numberOfThreads, std::chrono::steady_clock::time_point startTime, unsigned long long& lowerBound) {
 
-		if (!parentNodes.empty() && newState.validAfterExchange(node, parentNodes)) {
-			unsigned long long costs = newState.getCosts();
+	numberOfThreads = std::max(1, numberOfThreads);
+	bestState.costs = getCosts(bestState.nodeSet);
+	std::atomic<unsigned long long> bestCosts(bestState.costs);
+	std::mutex bestStateMutex;
 
-			if (costs < optimalCosts) {
+	VisitedStates visitedStates;
+	std::vector<WorkDeque> deques(numberOfThreads);
+	for (size_t i = 0; i < openStates.size(); i++) {
+		openStates[i].costs = getCosts(openStates[i].nodeSet);
+		visitedStates.insert(openStates[i].getCanonicalEncoding());
+		deques[i % numberOfThreads].states.push_back(std::move(openStates[i]));
+	}
+
+	// RN: successors are counted before their parent is done, so zero means that all work is done
+	std::atomic<long long> numberOfPendingStates(openStates.size());
+	std::atomic<bool> budgetExhausted(false);
+	openStates.clear();
+
+	auto popOrSteal = [&deques](int worker, NodeBasedState& state) {
+		for (int i = 0; i < (int) deques.size(); i++) {
+			WorkDeque& deque = deques[(worker + i) % deques.size()];
+			std::lock_guard<std::mutex> lock(deque.mutex);
+			if (deque.states.empty()) {
+				continue;
+			}
+			if (i == 0) {
+				state = std::move(deque.states.back());
+				deque.states.pop_back();
+			} else {
+				state = std::move(deque.states.front());
+				deque.states.pop_front();
+			}
+			return true;
+		}
+		return false;
+	};
+
+	auto work = [&](int worker) {
+		NodeBasedState state({}, {});
+		std::vector<NodeBasedState> successors;
+
+		while (!budgetExhausted) {
+			if (!popOrSteal(worker, state)) {
+				if (numberOfPendingStates == 0) {
+					return;
+				}
+				std::this_thread::yield();
+				continue;
+			}
 
-				///XXX
-				std::cout << "minimum: "
-						<< optimalCosts*CgConfig::nanosPerInstrumentedCall/1e9 << " s" << std::endl;
+			double elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+			if ((stepBudget > 0 && numberOfStepsTaken >= stepBudget)
+					|| (timeBudgetSeconds > .0 && elapsedSeconds >= timeBudgetSeconds)) {
+				budgetExhausted = true;
+				std::lock_guard<std::mutex> lock(deques[worker].mutex);
+				deques[worker].states.push_back(std::move(state));
+				return;
+			}
 
-				optimalCosts = costs;
-				optimalInstrumentation = newState.nodeSet;
+			// the incumbent might have improved since the state was pushed
+			if (getLowerBound(state) >= bestCosts) {
+				numberOfStepsPruned++;
+				numberOfPendingStates--;
+				continue;
 			}
-#if DEBUG
-			std::cout << "--> success" << std::endl;
-#endif
-			step(newState);
 
-		} else {
+			numberOfStepsTaken++;
+
+			successors.clear();
+			expand(state, successors);
+
+			for (auto& successor : successors) {
+				if (!visitedStates.insert(successor.getCanonicalEncoding())) {
+					numberOfStepsAvoided++;
+					continue;
+				}
+
+				if (successor.costs < bestCosts) {
+					std::lock_guard<std::mutex> lock(bestStateMutex);
+					if (successor.costs < bestState.costs) {
 #if DEBUG
-			std::cout << "--> fail" << std::endl;
+						std::cout << "minimum: " << successor.costs/1e9 << " s" << std::endl;
 #endif
+						bestState = successor;
+						bestCosts = successor.costs;
+					}
+				}
+
+				if (getLowerBound(successor) < bestCosts) {
+					numberOfPendingStates++;
+					std::lock_guard<std::mutex> lock(deques[worker].mutex);
+					deques[worker].states.push_back(std::move(successor));
+				} else {
+					numberOfStepsPruned++;
+				}
+			}
+			numberOfPendingStates--;
+		}
+	};
+
+	if (numberOfThreads == 1) {
+		work(0);
+	} else {
+		ThreadPool pool(numberOfThreads);
+		for (int worker = 0; worker < numberOfThreads; worker++) {
+			pool.enqueue([&work, worker]() { work(worker); });
+		}
+		pool.waitForAll();
+	}
+
+	// RN: the best plan is optimal up to the best lower bound of the states still open
+	lowerBound = bestState.costs;
+	for (auto& deque : deques) {
+		for (auto& state : deque.states) {
+			unsigned long long stateLowerBound = getLowerBound(state);
+			if (stateLowerBound < bestState.costs) {
+				lowerBound = std::min(lowerBound, stateLowerBound);
+				openStates.push_back(std::move(state));
+			}
 		}
 	}
+
+	return bestState;
+}
+
+//// ESTIMATOR PHASE
+
+OptimalNodeBasedEstimatorPhase::OptimalNodeBasedEstimatorPhase(int numberOfThreads, double timeBudgetSeconds,
+		unsigned long long stepBudget, std::string checkpointFile, bool solveClusters) :
+		// the open states of a checkpoint belong to the whole problem
+		EstimatorPhase(solveClusters && checkpointFile.empty() ? "NodeBasedClusters" : "NodeBasedOptimum"),
+		numberOfThreads(numberOfThreads),
+		timeBudgetSeconds(timeBudgetSeconds),
+		stepBudget(stepBudget),
+		checkpointFile(checkpointFile),
+		clustered(solveClusters && checkpointFile.empty()),
+		optimalCosts(ULLONG_MAX),
+		startingCosts(0),
+		lowerBound(0),
+		numberOfOpenStates(0),
+		resumed(false),
+		numberOfClusters(0),
+		largestCluster(0),
+		numberOfStepsTaken(0),
+		numberOfStepsAvoided(0),
+		numberOfStepsPruned(0) {
+}
+
+OptimalNodeBasedEstimatorPhase::~OptimalNodeBasedEstimatorPhase() {
 }
 
 void OptimalNodeBasedEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
 
-	findStartingState(mainMethod);
+	IndexedCallgraph indexedGraph(*graph);
+
+	// RN: the costs are in nanos, so an expensive probe (e.g., MPI) is moved to a cheaper parent
+	std::vector<unsigned long long> costs(indexedGraph.size());
+	for (size_t id = 0; id < indexedGraph.size(); id++) {
+		costs[id] = CgConfig::getCostModel().getInstrumentationNanos(*indexedGraph.getNode(id));
+	}
 
-	step(stateStack.top());
+	NodeBasedState optimalState = clustered
+			? solveClusters(indexedGraph, costs, mainMethod) : solve(indexedGraph, costs, mainMethod);
 
-	for (auto node : optimalInstrumentation) {
-		node->setState(CgNodeState::INSTRUMENT_WITNESS);
+	for (int id : optimalState.nodeSet) {
+		indexedGraph.getNode(id)->setState(CgNodeState::INSTRUMENT_WITNESS);
 	}
 	mainMethod->setState(CgNodeState::NONE);	// main() is implicitly instrumented
+}
+
+NodeBasedState OptimalNodeBasedEstimatorPhase::solve(const IndexedCallgraph& indexedGraph,
+		const std::vector<unsigned long long>& costs, CgNodePtr mainMethod) {
+
+	std::vector<int> conjunctions;
+	for (size_t id = 0; id < indexedGraph.size(); id++) {
+		if (CgHelper::isConjunction(indexedGraph.getNode(id))) {
+			conjunctions.push_back(id);
+		}
+	}
+
+	NodeBasedSolver solver(indexedGraph, costs, numberOfThreads, timeBudgetSeconds, stepBudget);
+	NodeBasedState startingState = findStartingState(indexedGraph, mainMethod, conjunctions);
+	startingCosts = solver.getCosts(startingState.nodeSet);
+
+	NodeBasedState bestState(startingState);
+	std::vector<NodeBasedState> openStates = {startingState};
+	if (!checkpointFile.empty()) {
+		resumed = readCheckpoint(indexedGraph, costs, bestState, openStates);
+	}
+
+	NodeBasedState optimalState = solver.solve(bestState, openStates);
+	optimalCosts = optimalState.costs;
+	lowerBound = solver.provenLowerBound;
+	numberOfOpenStates = openStates.size();
 
+	if (!checkpointFile.empty()) {
+		writeCheckpoint(indexedGraph, costs, optimalState, openStates);
+	}
+
+	numberOfStepsTaken = solver.numberOfStepsTaken;
+	numberOfStepsAvoided = solver.numberOfStepsAvoided;
+	numberOfStepsPruned = solver.numberOfStepsPruned;
+
+	return optimalState;
+}
+
+/**
+ * RN: The clusters are solved independently and the plan is the union of their plans. Nodes that are
+ * instrumented in several plans (at least main) are paid once, so the union is never more expensive than
+ * the sum of the cluster optima. As clusters can share ancestors, a plan whose probes serve several
+ * clusters can be cheaper than the union. Every plan of the whole graph is a plan of each cluster,
+ * so the most expensive cluster optimum is still a lower bound.
+ */
+NodeBasedState OptimalNodeBasedEstimatorPhase::solveClusters(const IndexedCallgraph& indexedGraph,
+		const std::vector<unsigned long long>& costs, CgNodePtr mainMethod) {
+
+	ConjunctionClusters clusters(indexedGraph);
+	numberOfClusters = clusters.size();
+	largestCluster = clusters.size() > 0 ? clusters.getConjunctions(0).size() : 0;
+
+	// the largest clusters come first, so they are solved while the small ones fill the other threads
+	int threadsPerCluster = std::max(1, numberOfThreads / (int) std::max<size_t>(1, clusters.size()));
+	int parallelClusters = std::max(1, numberOfThreads / threadsPerCluster);
+
+	NodeBasedSolver solver(indexedGraph, costs, numberOfThreads, timeBudgetSeconds, stepBudget);
+	auto startTime = std::chrono::steady_clock::now();
+
+	std::vector<NodeBasedState> clusterStates(clusters.size(), NodeBasedState({}, {}));
+	std::vector<unsigned long long> clusterLowerBounds(clusters.size(), 0);
+	std::vector<size_t> clusterOpenStates(clusters.size(), 0);
+
+	parallelFor(clusters.size(), [&](size_t cluster) {
+		NodeBasedState startingState = findStartingState(indexedGraph, mainMethod, clusters.getConjunctions(cluster));
+		std::vector<NodeBasedState> openStates = {startingState};
+
+		clusterStates[cluster] = solver.solve(startingState, openStates, threadsPerCluster, startTime,
+				clusterLowerBounds[cluster]);
+		clusterOpenStates[cluster] = openStates.size();
+	}, parallelClusters);
+
+	std::vector<int> startingNodes = {indexedGraph.getId(mainMethod)};
+	std::vector<int> optimalNodes = {indexedGraph.getId(mainMethod)};
+	lowerBound = solver.getCosts(optimalNodes);
+	numberOfOpenStates = 0;
+	for (size_t cluster = 0; cluster < clusters.size(); cluster++) {
+		auto& nodeSet = clusterStates[cluster].nodeSet;
+		optimalNodes.insert(optimalNodes.end(), nodeSet.begin(), nodeSet.end());
+		for (int conjunction : clusters.getConjunctions(cluster)) {
+			auto parents = indexedGraph.getParents(conjunction);
+			startingNodes.insert(startingNodes.end(), parents.begin(), parents.end());
+		}
+		lowerBound = std::max(lowerBound, clusterLowerBounds[cluster]);
+		numberOfOpenStates += clusterOpenStates[cluster];
+	}
+	std::sort(optimalNodes.begin(), optimalNodes.end());
+	optimalNodes.erase(std::unique(optimalNodes.begin(), optimalNodes.end()), optimalNodes.end());
+	std::sort(startingNodes.begin(), startingNodes.end());
+	startingNodes.erase(std::unique(startingNodes.begin(), startingNodes.end()), startingNodes.end());
+
+	NodeBasedState optimalState(optimalNodes, {});
+	optimalState.costs = solver.getCosts(optimalNodes);
+	optimalCosts = optimalState.costs;
+	startingCosts = solver.getCosts(startingNodes);
+
+	numberOfStepsTaken = solver.numberOfStepsTaken;
+	numberOfStepsAvoided = solver.numberOfStepsAvoided;
+	numberOfStepsPruned = solver.numberOfStepsPruned;
+
+	return optimalState;
 }
 
 void OptimalNodeBasedEstimatorPhase::printAdditionalReport() {
+	EstimatorPhase::printAdditionalReport();
 	std::cout << "\t" << "computation steps taken: " << numberOfStepsTaken
-			<< " (avoided " << numberOfStepsAvoided << ")" << std::endl;
+			<< " (avoided " << numberOfStepsAvoided << ", pruned " << numberOfStepsPruned << ")" << std::endl;
+	std::cout << "\t" << "instrumentation costs: " << optimalCosts << " ns (start " << startingCosts
+			<< " ns, lower bound " << lowerBound << " ns)" << std::endl;
+	double gap = (optimalCosts > 0) ? (double) (optimalCosts - lowerBound) / optimalCosts * 100 : .0;
+	if (numberOfOpenStates > 0) {
+		std::cout << "\t" << "budget exhausted: optimality gap " << gap << " % with "
+				<< numberOfOpenStates << " open states" << std::endl;
+	} else if (clustered) {
+		std::cout << "\t" << "heuristic: gap " << gap << " % to the lower bound" << std::endl;
+	}
+	if (resumed) {
+		std::cout << "\t" << "resumed from " << checkpointFile << std::endl;
+	}
+	if (numberOfClusters > 0) {
+		std::cout << "\t" << "solved " << numberOfClusters << " clusters of dependent conjunctions separately"
+				<< " (largest: " << largestCluster << " conjunctions)" << std::endl;
+	}
 }
 
-/** fill the initial stack with all parents of conjunctions and all initial constraints */
-void OptimalNodeBasedEstimatorPhase::findStartingState(CgNodePtr mainMethod) {
+/** all parents of the conjunctions are instrumented, every conjunction gives one constraint */
+NodeBasedState OptimalNodeBasedEstimatorPhase::findStartingState(const IndexedCallgraph& indexedGraph,
+		CgNodePtr mainMethod, const std::vector<int>& conjunctions) {
+
+	std::vector<int> startingParents = {indexedGraph.getId(mainMethod)};	// main() is implicitly instrumented
+	std::vector<NodeBasedConstraint> startingConstraints;
 
-	CgNodePtrSet startingParents = {mainMethod};	// main() is implicitly instrumented
-	NodeBasedConstraintContainer startingConstraints;
+	for (int id : conjunctions) {
+		auto range = indexedGraph.getParents(id);
+		std::vector<int> parentNodes(range.begin(), range.end());
+		std::sort(parentNodes.begin(), parentNodes.end());
 
-	for (auto node : (*graph)) {
-		if (CgHelper::isConjunction(node)) {
+		startingParents.insert(startingParents.end(), parentNodes.begin(), parentNodes.end());
+		startingConstraints.push_back(NodeBasedConstraint(parentNodes, id));
+	}
+
+	std::sort(startingParents.begin(), startingParents.end());
+	startingParents.erase(std::unique(startingParents.begin(), startingParents.end()), startingParents.end());
+
+	return NodeBasedState(startingParents, startingConstraints);
+}
 
-			CgNodePtrSet parentNodes = node->getParentNodes();
+namespace {
+	/** FNV-1a, a checkpoint has to be read by other builds of the tool, unlike std::hash */
+	uint64_t hashString(const std::string& s, uint64_t hash = 14695981039346656037ULL) {
+		for (char c : s) {
+			hash = (hash ^ (unsigned char) c) * 1099511628211ULL;
+		}
+		return hash;
+	}
 
-			startingParents.insert(parentNodes.begin(), parentNodes.end());
-			startingConstraints.push_back(NodeBasedConstraint(parentNodes, node));
+	/**
+	 * RN: the pruned states of a checkpoint are only valid for the same conjunctions & costs.
+	 * Every node (name & costs) and every edge is hashed on its own and the hashes are summed,
+	 * so the fingerprint does not depend on the ids of the IndexedCallgraph.
+	 */
+	std::string getFingerprint(const IndexedCallgraph& indexedGraph, const std::vector<unsigned long long>& costs) {
+		uint64_t nodes = 0;
+		uint64_t edges = 0;
+		for (size_t id = 0; id < indexedGraph.size(); id++) {
+			std::string name = indexedGraph.getNode(id)->getFunctionName();
+			nodes += hashString(std::to_string(costs[id]), hashString(name + '\t'));
+			for (int parent : indexedGraph.getParents(id)) {
+				edges += hashString(name, hashString(indexedGraph.getNode(parent)->getFunctionName() + '\t'));
+			}
 		}
+		std::ostringstream fingerprint;
+		fingerprint << indexedGraph.size() << "-" << std::hex << nodes << "-" << edges;
+		return fingerprint.str();
 	}
+}
 
-	auto startingState = NodeBasedState(startingParents, startingConstraints);
+/*
+ * RN: one line per entry, the fields are separated by tabs:
+ *   fingerprint <fingerprint of graph & costs>	(the first line)
+ *   best <node>...
+ *   state <node>...
+ *   constraint <conjunction> <node>...	(belongs to the last state)
+ */
+bool OptimalNodeBasedEstimatorPhase::readCheckpoint(const IndexedCallgraph& indexedGraph,
+		const std::vector<unsigned long long>& costs, NodeBasedState& bestState,
+		std::vector<NodeBasedState>& openStates) {
+
+	std::ifstream in(checkpointFile);
+	if (!in.is_open()) {
+		return false;	// nothing to resume
+	}
 
-	optimalInstrumentation = startingParents;
-	optimalCosts = startingState.getCosts();
+	std::string header;
+	std::getline(in, header);
+	if (header.compare(0, 12, "fingerprint\t") != 0) {
+		std::cerr << "ERROR: checkpoint " << checkpointFile << " has no fingerprint" << std::endl;
+		exit(1);
+	}
+	if (header.substr(12) != getFingerprint(indexedGraph, costs)) {
+		std::cerr << "ERROR: checkpoint " << checkpointFile << " belongs to another call graph or other costs" << std::endl;
+		exit(1);
+	}
+
+	auto getIds = [this, &indexedGraph](std::istringstream& fields) {
+		std::vector<int> ids;
+		std::string name;
+		while (std::getline(fields, name, '\t')) {
+			int id = indexedGraph.getId(graph->findNode(name));
+			if (id < 0) {
+				std::cerr << "ERROR: checkpoint " << checkpointFile << " contains unknown function " << name << std::endl;
+				exit(1);
+			}
+			ids.push_back(id);
+		}
+		return ids;
+	};
+
+	NodeBasedState checkpointBest({}, {});
+	std::vector<NodeBasedState> checkpointStates;
+	std::string line;
+	while (std::getline(in, line)) {
+		std::istringstream fields(line);
+		std::string kind;
+		std::getline(fields, kind, '\t');
+
+		if (kind == "best") {
+			checkpointBest.nodeSet = getIds(fields);
+			std::sort(checkpointBest.nodeSet.begin(), checkpointBest.nodeSet.end());
+		} else if (kind == "state") {
+			std::vector<int> nodeSet = getIds(fields);
+			std::sort(nodeSet.begin(), nodeSet.end());
+			checkpointStates.push_back(NodeBasedState(nodeSet, {}));
+		} else if (kind == "constraint" && !checkpointStates.empty()) {
+			std::vector<int> ids = getIds(fields);
+			if (ids.empty()) {
+				std::cerr << "ERROR: checkpoint " << checkpointFile << " has a constraint without conjunction" << std::endl;
+				exit(1);
+			}
+			std::vector<int> elements(ids.begin() + 1, ids.end());
+			std::sort(elements.begin(), elements.end());
+			checkpointStates.back().constraints.push_back(NodeBasedConstraint(elements, ids.front()));
+		} else if (!kind.empty()) {
+			std::cerr << "ERROR: checkpoint " << checkpointFile << " has a malformed line: " << line << std::endl;
+			exit(1);
+		}
+	}
 
-	stateStack.push(startingState);
+	if (checkpointBest.nodeSet.empty()) {
+		return false;
+	}
+	bestState = checkpointBest;
+	openStates.swap(checkpointStates);
+	return true;
 }
 
+void OptimalNodeBasedEstimatorPhase::writeCheckpoint(const IndexedCallgraph& indexedGraph,
+		const std::vector<unsigned long long>& costs, const NodeBasedState& bestState,
+		const std::vector<NodeBasedState>& openStates) {
 
+	std::ofstream out(checkpointFile, std::ofstream::out);
+	out << "fingerprint\t" << getFingerprint(indexedGraph, costs) << std::endl;
+	auto writeIds = [&out, &indexedGraph](const std::vector<int>& ids) {
+		for (int id : ids) {
+			out << "\t" << indexedGraph.getNode(id)->getFunctionName();
+		}
+		out << std::endl;
+	};
+
+	out << "best";
+	writeIds(bestState.nodeSet);
+	for (auto& state : openStates) {
+		out << "state";
+		writeIds(state.nodeSet);
+		for (auto& constraint : state.constraints) {
+			out << "constraint\t" << indexedGraph.getNode(constraint.conjunction)->getFunctionName();
+			writeIds(constraint.elements);
+		}
+	}
+}
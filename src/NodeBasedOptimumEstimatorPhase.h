@@ -1,178 +1,159 @@
-
 #ifndef NODEBASEDOPTIMUMESTIMATORPHASE_H_
 #define NODEBASEDOPTIMUMESTIMATORPHASE_H_
 
 #include "EstimatorPhase.h"
 #include "CgNode.h"
 #include "CgHelper.h"
+#include "IndexedCallgraph.h"
 
-#include <stack>
+#include <atomic>
+#include <chrono>
 #include <vector>
 #include <functional>	// std::hash
 
-struct NodeBasedConstraint;
-struct NodeBasedState;
-
-typedef std::vector<NodeBasedConstraint> NodeBasedConstraintContainer;
-
-
-class OptimalNodeBasedEstimatorPhase : public EstimatorPhase {
-public:
-	OptimalNodeBasedEstimatorPhase();
-	~OptimalNodeBasedEstimatorPhase();
-
-	void modifyGraph(CgNodePtr mainMethod);
-
-protected:
-	void printAdditionalReport();
-
-private:
-	std::stack<NodeBasedState> stateStack;
-
-	CgNodePtrSet optimalInstrumentation;
-	unsigned long long optimalCosts;
-
-	unsigned long long numberOfStepsTaken;
-	unsigned long long numberOfStepsAvoided;
-
-	// optimization for large data sets
-	std::set<std::size_t> visitedCombinations;
+/**
+ * RN: all node ids are the ones of an IndexedCallgraph, all id vectors are sorted.
+ */
+struct NodeBasedConstraint {
+	std::vector<int> elements;
+	int conjunction;
 
-	void findStartingState(CgNodePtr mainMethod);
+	NodeBasedConstraint(std::vector<int> elements, int conjunction) :
+		elements(elements), conjunction(conjunction) {}
 
-	void step(NodeBasedState& startState);
+	/** the paths to a conjunction must not meet again above the conjunction */
+	bool validAfterExchange(int oldElement, const std::vector<int>& newElements);
 };
 
-struct NodeBasedConstraint {
-	CgNodePtrSet elements;
-	CgNodePtr conjunctionNode;	// maybe this will come handy later
-
-	NodeBasedConstraint(CgNodePtrSet elements, CgNodePtr conjunction) {
-		this->elements = elements;
-		this->conjunctionNode = conjunction;
-	}
+struct NodeBasedState {
+	std::vector<int> nodeSet;	// the instrumented nodes
+	std::vector<NodeBasedConstraint> constraints;
+	unsigned long long costs;
 
-	inline
-	bool validAfterExchange(CgNodePtr oldElement, CgNodePtrSet newElements) {
+	NodeBasedState(std::vector<int> nodeSet, std::vector<NodeBasedConstraint> constraints) :
+		nodeSet(nodeSet), constraints(constraints), costs(0) {}
 
-		if (elements.find(oldElement) != elements.end()) {
-			CgNodePtrSet intersection = CgHelper::setIntersect(elements, newElements);
-			elements.insert(newElements.begin(), newElements.end());
+	bool validAfterExchange(int oldElement, const std::vector<int>& newElements);
 
-			return intersection.empty();
-		} else {
-			return true;
-		}
-	}
+	/** two states are the same iff their encodings are equal */
+	std::vector<int> getCanonicalEncoding() const;
+};
 
-	friend std::ostream& operator<< (std::ostream& stream, const NodeBasedConstraint& c) {
-		stream << "[";
-		for (auto element : c.elements) {
-			stream << *element << ", ";
+struct CanonicalEncodingHash {
+	size_t operator()(const std::vector<int>& encoding) const {
+		size_t seed = encoding.size();
+		for (int i : encoding) {
+			// according to stackoverflow this is a decent hash function
+			seed ^= std::hash<int>()(i) + 0x9e3779b9UL + (seed<<6) + (seed>>2);
 		}
-		stream << "]";
-
-		return stream;
+		return seed;
 	}
 };
 
-struct NodeBasedState {
-	CgNodePtrSet nodeSet;
-	NodeBasedConstraintContainer constraints;
-
-	NodeBasedState(CgNodePtrSet nodeSet, NodeBasedConstraintContainer constraints) {
-		this->nodeSet = nodeSet;
-		this->constraints = constraints;
-	}
+/**
+ * Branch and bound search for the cheapest valid node based instrumentation.
+ * Every worker thread owns a deque of open states: it continues depth first at the back,
+ * idle workers steal the oldest states (the largest subtrees) from the front of other deques.
+ * A move replaces an instrumented node by all of its parents.
+ * The lower bound of a state holds for all states reachable from it:
+ * the instrumented nodes on the paths to one conjunction can only move to distinct ancestors,
+ * so each of them costs at least as much as the cheapest way to move it up (or to keep it).
+ */
+class NodeBasedSolver {
+public:
+	/** a budget of 0 is unlimited */
+	NodeBasedSolver(const IndexedCallgraph& indexedGraph, const std::vector<unsigned long long>& costs,
+			int numberOfThreads = 1, double timeBudgetSeconds = .0, unsigned long long stepBudget = 0);
+
+	/**
+	 * Searches from the open states (usually just the starting state) for a state cheaper than bestState.
+	 * If the budget runs out, the states that are still open are left in openStates.
+	 */
+	NodeBasedState solve(NodeBasedState bestState, std::vector<NodeBasedState>& openStates);
+	/**
+	 * The same for one of several independent subproblems that are solved at the same time.
+	 * The budget is shared: steps are counted over all subproblems, the time runs from startTime.
+	 */
+	NodeBasedState solve(NodeBasedState bestState, std::vector<NodeBasedState>& openStates,
+			int numberOfThreads, std::chrono::steady_clock::time_point startTime, unsigned long long& lowerBound);
+
+	unsigned long long getCosts(const std::vector<int>& nodeSet) const;
+	unsigned long long getLowerBound(const NodeBasedState& state) const;
+	/** all valid successors of a state, the most promising one comes last */
+	void expand(const NodeBasedState& state, std::vector<NodeBasedState>& successors) const;
+
+	std::atomic<unsigned long long> numberOfStepsTaken;
+	std::atomic<unsigned long long> numberOfStepsAvoided;
+	std::atomic<unsigned long long> numberOfStepsPruned;
+	/** no plan is cheaper, equals the costs of the best state if the search finished */
+	unsigned long long provenLowerBound;
 
-	inline
-	bool validAfterExchange(CgNodePtr oldElement, CgNodePtrSet newElements) {
+private:
+	int numberOfThreads;
+	double timeBudgetSeconds;
+	unsigned long long stepBudget;
+
+	std::vector<std::vector<int> > parents;
+	std::vector<unsigned long long> costs;
+	std::vector<unsigned long long> minMoveCosts;
+	std::vector<unsigned long long> minMoveCostsWithoutFree;
+	size_t numberOfFreeNodes;
+};
 
-		if(nodeSet.find(oldElement) != nodeSet.end()) {
-			nodeSet.erase(oldElement);
-			nodeSet.insert(newElements.begin(), newElements.end());
-		}
-		for (auto& constraint : constraints) {
-			if (!constraint.validAfterExchange(oldElement, newElements)) {
-				return false;
-			}
-		}
+/**
+ * RN: With a time or step budget the phase returns the best plan found so far and its optimality gap.
+ * If a checkpoint file is given, the open states are stored in it and a later run resumes from them.
+ * With solveClusters (and without checkpoint) every cluster of dependent conjunctions (see ConjunctionClusters)
+ * is solved on its own, the clusters in parallel, and the plan is the union of their plans. This is a heuristic:
+ * the clusters can share marker positions, so the union is not proven optimal. The phase is then
+ * called NodeBasedClusters and always reports its gap to the lower bound. The budgets hold for all clusters.
+ */
+class OptimalNodeBasedEstimatorPhase : public EstimatorPhase {
+public:
+	OptimalNodeBasedEstimatorPhase(int numberOfThreads = 1, double timeBudgetSeconds = .0,
+			unsigned long long stepBudget = 0, std::string checkpointFile = "", bool solveClusters = false);
+	~OptimalNodeBasedEstimatorPhase();
 
-		return true;
-	}
+	void modifyGraph(CgNodePtr mainMethod);
 
-	inline
-	unsigned long long getCosts() {
-		// note that the scumbag zero will break everything unless it is explicitly "ULL"
-		return std::accumulate( nodeSet.begin(), nodeSet.end(), 0ULL,
-				[](unsigned long long calls, CgNodePtr node) {
-					return calls + node->getNumberOfCalls();
-				});
-	}
+protected:
+	void printAdditionalReport();
 
-	friend std::ostream& operator<< (std::ostream& stream, const NodeBasedState& state) {
+private:
+	int numberOfThreads;
+	double timeBudgetSeconds;
+	unsigned long long stepBudget;
+	std::string checkpointFile;
+	bool clustered;
 
-		stream << "-- marked: ";
-		for (auto node : state.nodeSet) {
-			stream << *node << ", ";
-		}
-		stream << "-- constraints: ";
-		for (auto c : state.constraints) {
-			stream << c << ", ";
-		}
-		stream << "--";
+	unsigned long long optimalCosts;
+	unsigned long long startingCosts;
+	unsigned long long lowerBound;
+	size_t numberOfOpenStates;
+	bool resumed;
+	size_t numberOfClusters;
+	size_t largestCluster;
 
-		return stream;
-	}
+	unsigned long long numberOfStepsTaken;
+	unsigned long long numberOfStepsAvoided;
+	unsigned long long numberOfStepsPruned;
+
+	NodeBasedState findStartingState(const IndexedCallgraph& indexedGraph, CgNodePtr mainMethod,
+			const std::vector<int>& conjunctions);
+
+	NodeBasedState solve(const IndexedCallgraph& indexedGraph, const std::vector<unsigned long long>& costs,
+			CgNodePtr mainMethod);
+	NodeBasedState solveClusters(const IndexedCallgraph& indexedGraph, const std::vector<unsigned long long>& costs,
+			CgNodePtr mainMethod);
+
+	/**
+	 * nodes are stored by name, the ids of an IndexedCallgraph change with the graph.
+	 * A checkpoint only belongs to the graph & costs of its fingerprint, the tool exits on another one.
+	 */
+	bool readCheckpoint(const IndexedCallgraph& indexedGraph, const std::vector<unsigned long long>& costs,
+			NodeBasedState& bestState, std::vector<NodeBasedState>& openStates);
+	void writeCheckpoint(const IndexedCallgraph& indexedGraph, const std::vector<unsigned long long>& costs,
+			const NodeBasedState& bestState, const std::vector<NodeBasedState>& openStates);
 };
 
-template <class T>
-inline std::size_t hashCombine(const std::size_t seed, const T toBeHashed) {
-	// according to stackoverflow this is a decent hash function
-	return seed ^ ( std::hash<T>()(toBeHashed) + 0x9e3779b9UL + (seed<<6) + (seed>>2) ) ;
-}
-
-namespace std {
-
-	template <>
-	struct hash<CgNodePtrSet> {
-		inline size_t operator()(const CgNodePtrSet& key) const {
-
-			return std::accumulate(
-					key.begin(),
-					key.end(),
-					(size_t) 0,
-					[](size_t acc, const CgNodePtr n) {
-						// use pointer address for hash of CgNode
-						return hashCombine<size_t>(acc, (size_t) n.get());
-					}
-			);
-		}
-	};
-
-	template <>
-	struct hash<NodeBasedConstraintContainer> {
-		size_t operator()(const NodeBasedConstraintContainer& key) const {
-
-			return std::accumulate(
-					key.begin(),
-					key.end(),
-					(size_t) 0,
-					[](size_t acc, const NodeBasedConstraint c) {
-						return hashCombine<CgNodePtrSet>(acc, c.elements);
-					}
-			);
-		}
-	};
-
-	template <>
-	struct hash<NodeBasedState> {
-		size_t operator()(const NodeBasedState& key) const {
-
-			size_t nodeSetHash = hash<CgNodePtrSet>()(key.nodeSet);
-			return hashCombine<NodeBasedConstraintContainer>(nodeSetHash, key.constraints);
-		}
-	};
-}
-
 #endif
@@ -0,0 +1,176 @@
+#include "OverheadBudgetEstimatorPhase.h"
+
+#include <algorithm>
+#include <queue>
+
+OverheadBudgetEstimatorPhase::OverheadBudgetEstimatorPhase(double budgetPercent, double conjunctionWeight) :
+		EstimatorPhase("OvBudget" + std::to_string(budgetPercent)),
+		budgetPercent(budgetPercent),
+		conjunctionWeight(conjunctionWeight),
+		budgetSeconds(.0),
+		usedSeconds(.0),
+		coveredSeconds(.0),
+		overallSeconds(.0),
+		numberOfCandidates(0),
+		numberOfSelected(0),
+		bestSingleIsBetter(false) {
+}
+
+void OverheadBudgetEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
+
+	double runtime = (config->referenceRuntime > .0) ? config->referenceRuntime : config->actualRuntime;
+	budgetSeconds = runtime * budgetPercent / 100;
+
+	IndexedCallgraph indexedGraph(*graph);
+	int mainId = indexedGraph.getId(mainMethod);
+	std::vector<double> inclusiveRuntimes = getInclusiveRuntimes(indexedGraph, mainId);
+
+	// the share of the conjunctions does not depend on the other selected functions
+	std::vector<double> conjunctionValues(indexedGraph.size(), .0);
+	std::vector<Candidate> candidates;
+	candidates.reserve(indexedGraph.size());
+	for (size_t id = 0; id < indexedGraph.size(); id++) {
+		auto node = indexedGraph.getNode(id);
+		if ((int) id == mainId) {
+			continue;	// main() is implicitly instrumented
+		}
+
+		for (auto& conjunction : node->getDependentConjunctionsConst()) {
+			int conjunctionId = indexedGraph.getId(conjunction);
+			if (conjunctionId >= 0) {
+				conjunctionValues[id] += conjunctionWeight * inclusiveRuntimes[conjunctionId]
+						/ conjunction->getMarkerPositionsConst().size();
+			}
+		}
+		double value = inclusiveRuntimes[id] + conjunctionValues[id];
+		double costSeconds = (double) CgConfig::getCostModel().getInstrumentationNanos(*node) / 1e9;
+
+		if (value > .0 && costSeconds <= budgetSeconds) {
+			candidates.push_back(Candidate{(int) id, value, costSeconds});
+		}
+	}
+	numberOfCandidates = candidates.size();
+
+	// RN: a * d > b * c avoids the division for functions that are never called
+	auto lessValuePerCost = [](const Candidate& lhs, const Candidate& rhs) {
+		return lhs.value * rhs.costSeconds < rhs.value * lhs.costSeconds;
+	};
+
+	// RN: the value of a candidate only decreases with every selected function (submodular),
+	// so a stale value is an upper bound and only the top of the heap has to be updated
+	std::vector<bool> covered(indexedGraph.size(), false);
+	std::priority_queue<Candidate, std::vector<Candidate>, decltype(lessValuePerCost)> heap(
+			lessValuePerCost, candidates);
+
+	std::vector<int> selected;
+	double greedyValue = .0;
+	while (!heap.empty()) {
+		Candidate candidate = heap.top();
+		heap.pop();
+		if (usedSeconds + candidate.costSeconds > budgetSeconds) {
+			continue;
+		}
+
+		candidate.value = getUncoveredRuntime(indexedGraph, candidate.id, mainId, covered, false)
+				+ conjunctionValues[candidate.id];
+		if (candidate.value <= .0) {
+			continue;
+		}
+		if (!heap.empty() && lessValuePerCost(candidate, heap.top())) {
+			heap.push(candidate);
+			continue;
+		}
+
+		getUncoveredRuntime(indexedGraph, candidate.id, mainId, covered, true);
+		usedSeconds += candidate.costSeconds;
+		greedyValue += candidate.value;
+		selected.push_back(candidate.id);
+	}
+	coveredSeconds = .0;
+	for (size_t id = 0; id < indexedGraph.size(); id++) {
+		if (covered[id] && (int) id != mainId) {
+			coveredSeconds += indexedGraph.getNode(id)->getRuntimeInSeconds();
+		}
+	}
+
+	// the value of a single function is its inclusive runtime, the same measure as for the greedy selection
+	auto bestSingle = std::max_element(candidates.begin(), candidates.end(),
+			[](const Candidate& lhs, const Candidate& rhs) { return lhs.value < rhs.value; });
+	// RN: the greedy value is summed in another order, a selected function can not beat the greedy selection
+	if (bestSingle != candidates.end() && bestSingle->value > greedyValue
+			&& std::find(selected.begin(), selected.end(), bestSingle->id) == selected.end()) {
+		bestSingleIsBetter = true;
+		usedSeconds = bestSingle->costSeconds;
+		selected.assign(1, bestSingle->id);
+		coveredSeconds = inclusiveRuntimes[bestSingle->id];
+	}
+
+	for (int id : selected) {
+		indexedGraph.getNode(id)->setState(CgNodeState::INSTRUMENT_WITNESS);
+	}
+	numberOfSelected = selected.size();
+}
+
+/** main() is instrumented anyway, its own runtime is never covered by the phase */
+std::vector<double> OverheadBudgetEstimatorPhase::getInclusiveRuntimes(const IndexedCallgraph& indexedGraph,
+		int mainId) {
+
+	auto runtime = [&indexedGraph, mainId](int id) {
+		return (id == mainId) ? .0 : indexedGraph.getNode(id)->getRuntimeInSeconds();
+	};
+
+	overallSeconds = .0;
+	for (size_t id = 0; id < indexedGraph.size(); id++) {
+		overallSeconds += runtime(id);
+	}
+
+	InclusiveMetricEngine engine(indexedGraph);
+	return engine.compute(runtime);
+}
+
+/** RN: the covered functions are closed under their callees, so the search stops at them */
+double OverheadBudgetEstimatorPhase::getUncoveredRuntime(const IndexedCallgraph& indexedGraph, int id, int mainId,
+		std::vector<bool>& covered, bool cover) const {
+
+	if (covered[id]) {
+		return .0;
+	}
+	std::vector<int> reached(1, id);
+	covered[id] = true;
+
+	double seconds = .0;
+	for (size_t i = 0; i < reached.size(); i++) {
+		int current = reached[i];
+		if (current != mainId) {
+			seconds += indexedGraph.getNode(current)->getRuntimeInSeconds();
+		}
+
+		for (int child : indexedGraph.getChildren(current)) {
+			if (!covered[child]) {
+				covered[child] = true;
+				reached.push_back(child);
+			}
+		}
+	}
+
+	if (!cover) {
+		for (int current : reached) {
+			covered[current] = false;
+		}
+	}
+	return seconds;
+}
+
+void OverheadBudgetEstimatorPhase::printAdditionalReport() {
+	EstimatorPhase::printAdditionalReport();
+
+	double usedPercent = (budgetSeconds > .0) ? usedSeconds / budgetSeconds * budgetPercent : .0;
+	double coveredPercent = (overallSeconds > .0) ? coveredSeconds / overallSeconds * 100 : .0;
+
+	std::cout << "\t" << "budget: " << budgetPercent << " % (" << budgetSeconds << " s)"
+			<< " | used: " << usedPercent << " % (" << usedSeconds << " s)"
+			<< " | instrumented " << numberOfSelected << " of " << numberOfCandidates << " candidates"
+			<< (bestSingleIsBetter ? " (single best function)" : "") << std::endl;
+	std::cout << "\t" << "covered runtime: " << coveredSeconds << " s of " << overallSeconds << " s"
+			<< " (" << coveredPercent << " %)" << std::endl;
+}
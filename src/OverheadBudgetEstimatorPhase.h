@@ -0,0 +1,55 @@
+#ifndef OVERHEADBUDGETESTIMATORPHASE_H_
+#define OVERHEADBUDGETESTIMATORPHASE_H_
+
+#include "EstimatorPhase.h"
+#include "IndexedCallgraph.h"
+#include "InclusiveMetricEngine.h"
+
+#include <vector>
+
+/**
+ * RN: Instruments the functions that cover the most runtime while the instrumentation
+ * overhead stays within a budget (in percent of the reference runtime).
+ * An instrumented function covers the runtime of all functions reachable from it, the value
+ * of a selection is the runtime of the union of their coverage plus, for every selected function,
+ * a share of the inclusive runtime of every conjunction it differentiates (as potential marker position).
+ * The cost is its number of calls times its probe costs in the CgConfig::getCostModel().
+ * main() is implicitly instrumented, it is neither a candidate nor part of the covered runtime.
+ * The knapsack is approximated by a lazy greedy on the marginal value per cost, the better of the greedy
+ * selection and the most valuable single function is taken.
+ */
+class OverheadBudgetEstimatorPhase : public EstimatorPhase {
+public:
+	OverheadBudgetEstimatorPhase(double budgetPercent, double conjunctionWeight = 1.0);
+	~OverheadBudgetEstimatorPhase() {}
+
+	void modifyGraph(CgNodePtr mainMethod);
+
+protected:
+	void printAdditionalReport();
+
+private:
+	struct Candidate {
+		int id;
+		double value;
+		double costSeconds;
+	};
+
+	std::vector<double> getInclusiveRuntimes(const IndexedCallgraph& indexedGraph, int mainId);
+	/** the runtime of the functions below id that are not covered yet, with cover they are covered afterwards */
+	double getUncoveredRuntime(const IndexedCallgraph& indexedGraph, int id, int mainId,
+			std::vector<bool>& covered, bool cover) const;
+
+	double budgetPercent;
+	double conjunctionWeight;
+
+	double budgetSeconds;
+	double usedSeconds;
+	double coveredSeconds;
+	double overallSeconds;
+	int numberOfCandidates;
+	int numberOfSelected;
+	bool bestSingleIsBetter;
+};
+
+#endif
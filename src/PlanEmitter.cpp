@@ -0,0 +1,266 @@
+#include "PlanEmitter.h"
+
+#include "AhoCorasick.h"
+
+#include <cxxabi.h>
+
+#include <cctype>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+/** backslashes before the characters with a special meaning in glob patterns */
+std::string escapeGlob(const std::string& name) {
+	std::string escaped;
+	for (char c : name) {
+		if (c == '*' || c == '?' || c == '[' || c == ']' || c == '\\') {
+			escaped += '\\';
+		}
+		escaped += c;
+	}
+	return escaped;
+}
+
+bool isMangled(const std::string& name) {
+	return name.compare(0, 2, "_Z") == 0;
+}
+
+/** a C function or a mangled C++ function, names with parameters or scopes are demangled C++ functions */
+bool isLinkageName(const std::string& name) {
+	for (char c : name) {
+		if (!isalnum((unsigned char) c) && c != '_' && c != '.' && c != '$') {
+			return false;
+		}
+	}
+	return !name.empty();
+}
+
+/** RN: GCC matches the user visible name, so the parameters of a demangled name are dropped */
+std::string getUserVisibleName(const std::string& name) {
+	if (!isMangled(name)) {
+		return name;
+	}
+	int status = 0;
+	char* demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+	if (status != 0 || demangled == nullptr) {
+		return name;
+	}
+	std::string result(demangled);
+	free(demangled);
+
+	auto parameters = result.find('(');
+	return (parameters == std::string::npos || parameters == 0) ? result : result.substr(0, parameters);
+}
+
+std::string quoteJSON(const std::string& s) {
+	std::ostringstream quoted;
+	quoted << '"';
+	for (char c : s) {
+		switch (c) {
+		case '"': quoted << "\\\""; break;
+		case '\\': quoted << "\\\\"; break;
+		case '\n': quoted << "\\n"; break;
+		case '\t': quoted << "\\t"; break;
+		default:
+			if ((unsigned char) c < 0x20) {
+				quoted << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int) c << std::dec;
+			} else {
+				quoted << c;
+			}
+		}
+	}
+	quoted << '"';
+	return quoted.str();
+}
+
+}
+
+//// PLAN EMITTER
+
+std::unique_ptr<PlanEmitter> PlanEmitter::create(std::string format) {
+	if (format == "plain") {
+		return std::unique_ptr<PlanEmitter>(new PlainPlanEmitter());
+	}
+	if (format == "scorep") {
+		return std::unique_ptr<PlanEmitter>(new ScorePPlanEmitter());
+	}
+	if (format == "gcc") {
+		return std::unique_ptr<PlanEmitter>(new GCCPlanEmitter());
+	}
+	if (format == "xray") {
+		return std::unique_ptr<PlanEmitter>(new XRayPlanEmitter());
+	}
+	if (format == "callsite") {
+		return std::unique_ptr<PlanEmitter>(new CallsitePlanEmitter());
+	}
+	if (format == "json") {
+		return std::unique_ptr<PlanEmitter>(new JSONPlanEmitter());
+	}
+	return nullptr;
+}
+
+std::vector<std::string> PlanEmitter::getFormats() {
+	return {"plain", "scorep", "gcc", "xray", "callsite", "json"};
+}
+
+//// PLAIN
+
+void PlainPlanEmitter::emit(const CgReport& report, const Callgraph& graph, std::ostream& out) const {
+	for (auto& name : report.instrumentedNames) {
+		out << name << std::endl;
+	}
+}
+
+//// SCORE-P
+
+/** RN: Score-P splits patterns at whitespace, so whitespace in a name is matched by '?' */
+void ScorePPlanEmitter::emit(const CgReport& report, const Callgraph& graph, std::ostream& out) const {
+	out << "# " << report.phaseName << ": " << report.instrumentedMethods << " instrumented functions" << std::endl;
+	out << "SCOREP_REGION_NAMES_BEGIN" << std::endl;
+	out << "  EXCLUDE *" << std::endl;
+
+	for (auto& name : report.instrumentedNames) {
+		std::string pattern = escapeGlob(name);
+		for (char& c : pattern) {
+			if (c == ' ' || c == '\t') {
+				c = '?';
+			}
+		}
+		out << "  INCLUDE " << (isMangled(name) ? "MANGLED " : "") << pattern << std::endl;
+	}
+	out << "SCOREP_REGION_NAMES_END" << std::endl;
+}
+
+//// GCC
+
+void GCCPlanEmitter::emit(const CgReport& report, const Callgraph& graph, std::ostream& out) const {
+
+	std::vector<std::string> candidates;
+	AhoCorasick excludedNames;
+	for (auto& node : graph) {
+		std::string name = getUserVisibleName(node->getFunctionName());
+		if (report.instrumentedNames.count(node->getFunctionName()) == 0) {
+			candidates.push_back(name);
+			excludedNames.add(name);
+		}
+	}
+	excludedNames.build();
+
+	// a name that is part of an instrumented name would exclude that function too
+	std::vector<bool> excludable(candidates.size(), true);
+	for (auto& name : report.instrumentedNames) {
+		excludedNames.search(getUserVisibleName(name), [&excludable](int keyword) { excludable[keyword] = false; });
+	}
+
+	std::string list;
+	int numberNotExcluded = 0;
+	for (size_t i = 0; i < candidates.size(); i++) {
+		// GCC splits the list at commas
+		if (!excludable[i] || candidates[i].empty() || candidates[i].find(',') != std::string::npos) {
+			numberNotExcluded++;
+			continue;
+		}
+		list += (list.empty() ? "" : ",") + candidates[i];
+	}
+
+	out << "# " << report.phaseName << ": " << report.instrumentedMethods << " instrumented functions, "
+			<< numberNotExcluded << " other functions can not be excluded" << std::endl;
+	out << "-finstrument-functions" << std::endl;
+	if (list.empty()) {
+		return;
+	}
+
+	out << "\"-finstrument-functions-exclude-function-list=";
+	for (char c : list) {
+		if (c == '"' || c == '\\') {
+			out << '\\';
+		}
+		out << c;
+	}
+	out << "\"" << std::endl;
+}
+
+//// XRAY
+
+void XRayPlanEmitter::emit(const CgReport& report, const Callgraph& graph, std::ostream& out) const {
+	// RN: a batch job must not end here, so the demangled names are only left out
+	std::vector<std::string> names;
+	for (auto& name : report.instrumentedNames) {
+		if (isLinkageName(name)) {
+			names.push_back(name);
+		} else {
+			std::cerr << "WARNING: XRay matches mangled names, the demangled function " << name
+					<< " is left out of the plan of " << report.phaseName << std::endl;
+		}
+	}
+
+	out << "# " << report.phaseName << ": " << report.instrumentedMethods << " instrumented functions";
+	if (names.size() < report.instrumentedNames.size()) {
+		out << ", " << report.instrumentedNames.size() - names.size() << " demangled ones left out";
+	}
+	out << std::endl;
+	out << "[always]" << std::endl;
+	for (auto& name : names) {
+		out << "fun:" << escapeGlob(name) << std::endl;
+	}
+	out << "[never]" << std::endl;
+	out << "fun:*" << std::endl;
+}
+
+//// CALLSITE
+
+void CallsitePlanEmitter::emit(const CgReport& report, const Callgraph& graph, std::ostream& out) const {
+	out << "# " << report.phaseName << ": " << report.instrumentedMethods << " instrumented functions, "
+			<< report.instrumentedCallsites.size() << " instrumented callsites" << std::endl;
+	for (auto& name : report.instrumentedNames) {
+		out << "FUNCTION\t" << name << std::endl;
+	}
+	for (auto& callsite : report.instrumentedCallsites) {
+		out << "CALLSITE\t" << callsite.caller << "\t" << callsite.callee << "\t" << callsite.filename
+				<< "\t" << callsite.line << "\t" << callsite.numberOfCalls << std::endl;
+	}
+}
+
+//// JSON
+
+void JSONPlanEmitter::emit(const CgReport& report, const Callgraph& graph, std::ostream& out) const {
+	out << "{" << std::endl;
+	out << "  \"phase\": " << quoteJSON(report.phaseName) << "," << std::endl;
+	out << "  \"overheadPercent\": " << report.overallPercent << "," << std::endl;
+	out << "  \"overheadSeconds\": " << report.overallSeconds << "," << std::endl;
+
+	// the most frequently called function first
+	auto instrumentedNodes = report.instrumentedNodes;
+	out << "  \"instrumented\": [";
+	for (bool first = true; !instrumentedNodes.empty(); first = false) {
+		auto node = instrumentedNodes.top();
+		instrumentedNodes.pop();
+		out << (first ? "" : ",") << std::endl << "    {\"name\": " << quoteJSON(node->getFunctionName())
+				<< ", \"calls\": " << node->getNumberOfCalls() << "}";
+	}
+	out << std::endl << "  ]," << std::endl;
+
+	out << "  \"unwound\": [";
+	bool first = true;
+	for (auto& pair : report.unwoundNames) {
+		out << (first ? "" : ",") << std::endl << "    {\"name\": " << quoteJSON(pair.first)
+				<< ", \"unwindSteps\": " << pair.second << "}";
+		first = false;
+	}
+	out << std::endl << "  ]," << std::endl;
+
+	out << "  \"callsites\": [";
+	first = true;
+	for (auto& callsite : report.instrumentedCallsites) {
+		out << (first ? "" : ",") << std::endl << "    {\"caller\": " << quoteJSON(callsite.caller)
+				<< ", \"callee\": " << quoteJSON(callsite.callee)
+				<< ", \"filename\": " << quoteJSON(callsite.filename)
+				<< ", \"line\": " << callsite.line << ", \"calls\": " << callsite.numberOfCalls << "}";
+		first = false;
+	}
+	out << std::endl << "  ]" << std::endl;
+	out << "}" << std::endl;
+}
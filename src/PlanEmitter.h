@@ -0,0 +1,86 @@
+#ifndef PLANEMITTER_H_
+#define PLANEMITTER_H_
+
+#include "Callgraph.h"
+#include "EstimatorPhase.h"
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Writes the plan of a phase (its report) in the input format of an instrumentation mechanism,
+ * so a plan is applied without post-processing scripts. The plans are written to
+ * <outputPath>/plan-<app>-<phase>.<extension> for every format given with --emit.
+ */
+class PlanEmitter {
+public:
+	virtual ~PlanEmitter() {}
+
+	virtual std::string getExtension() const = 0;
+	virtual void emit(const CgReport& report, const Callgraph& graph, std::ostream& out) const = 0;
+
+	/** nullptr for an unknown format */
+	static std::unique_ptr<PlanEmitter> create(std::string format);
+	static std::vector<std::string> getFormats();
+};
+
+/** the instrumented functions, one name per line */
+class PlainPlanEmitter : public PlanEmitter {
+public:
+	std::string getExtension() const { return "txt"; }
+	void emit(const CgReport& report, const Callgraph& graph, std::ostream& out) const;
+};
+
+/**
+ * A Score-P filter file (SCOREP_FILTERING_FILE) that excludes everything but the instrumented functions.
+ * Mangled names are written as MANGLED patterns.
+ */
+class ScorePPlanEmitter : public PlanEmitter {
+public:
+	std::string getExtension() const { return "filter"; }
+	void emit(const CgReport& report, const Callgraph& graph, std::ostream& out) const;
+};
+
+/**
+ * A GCC response file (gcc @FILE ...) with -finstrument-functions-exclude-function-list.
+ * GCC excludes every function whose name contains one of the listed names, so a function is
+ * only listed if its name is not part of the name of an instrumented function.
+ * The others stay instrumented and are counted in a comment.
+ */
+class GCCPlanEmitter : public PlanEmitter {
+public:
+	std::string getExtension() const { return "gcc"; }
+	void emit(const CgReport& report, const Callgraph& graph, std::ostream& out) const;
+};
+
+/**
+ * An LLVM XRay attribute list (-fxray-attr-list=FILE), the instrumented functions are always instrumented.
+ * XRay matches the mangled names, demangled C++ names are left out with a warning (--emit xray needs --mangled).
+ */
+class XRayPlanEmitter : public PlanEmitter {
+public:
+	std::string getExtension() const { return "xray"; }
+	void emit(const CgReport& report, const Callgraph& graph, std::ostream& out) const;
+};
+
+/**
+ * The instrumented functions and the instrumented callsites (see CallsiteInstrumentationEstimatorPhase),
+ * tab separated: FUNCTION name or CALLSITE caller callee filename line calls.
+ * The other formats only have the functions.
+ */
+class CallsitePlanEmitter : public PlanEmitter {
+public:
+	std::string getExtension() const { return "callsites"; }
+	void emit(const CgReport& report, const Callgraph& graph, std::ostream& out) const;
+};
+
+/** the whole plan including the unwind depths and the expected overhead */
+class JSONPlanEmitter : public PlanEmitter {
+public:
+	std::string getExtension() const { return "json"; }
+	void emit(const CgReport& report, const Callgraph& graph, std::ostream& out) const;
+};
+
+#endif
@@ -1,10 +1,38 @@
 #include "ProximityMeasureEstimatorPhase.h"
 
+#include "InclusiveMetricEngine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
 ProximityMeasureEstimatorPhase::ProximityMeasureEstimatorPhase(
-    std::string filename)
+    std::string filename, int numberOfThreads)
     : EstimatorPhase("proximity-estimator"), filename(filename),
-      compareAgainst(CubeCallgraphBuilder::build(filename, config)) {
-  std::cout << "Everything constructed" << std::endl;
+      numberOfThreads(numberOfThreads) {}
+
+void ProximityMeasureEstimatorPhase::loadComparisonProfile() {
+  if (compareAgainst) {
+    return;
+  }
+
+  compareAgainst.reset(
+      new CallgraphManager(CubeCallgraphBuilder::build(filename, config)));
+  comparisonGraph.reset(
+      new Callgraph(compareAgainst->getCallgraph(compareAgainst.get())));
+  indexedComparison.reset(new IndexedCallgraph(*comparisonGraph));
+
+  // the name index both graphs are joined through
+  comparisonIds.reserve(indexedComparison->size());
+  for (size_t id = 0; id < indexedComparison->size(); id++) {
+    comparisonIds[indexedComparison->getNode(id)->getFunctionName()] = id;
+  }
+
+  InclusiveMetricEngine engine(*indexedComparison, numberOfThreads);
+  comparisonInclusiveRuntimes = engine.compute([this](int id) {
+    return indexedComparison->getNode(id)->getRuntimeInSeconds();
+  });
 }
 
 void ProximityMeasureEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
@@ -14,137 +42,141 @@ void ProximityMeasureEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
     return;
   }
 
+  loadComparisonProfile();
+
   // Prepare the Callgraph for the processing
-  std::for_each(graph->begin(), graph->end(), [this](const CgNodePtr n) {
-    this->getInclusiveAndChildrenRuntime(n);
+  indexedGraph.reset(new IndexedCallgraph(*graph));
+  InclusiveMetricEngine engine(*indexedGraph, numberOfThreads);
+  inclusiveRuntimes = engine.compute([this](int id) {
+    return indexedGraph->getNode(id)->getRuntimeInSeconds();
   });
+  for (size_t id = 0; id < indexedGraph->size(); id++) {
+    indexedGraph->getNode(id)->setInclusiveRuntimeInSeconds(
+        inclusiveRuntimes[id]);
+  }
+
+  // join the functions reachable from main with the comparison profile
+  table = ComparisonTable();
+  std::vector<bool> visited(indexedGraph->size(), false);
+  int mainId = indexedGraph->getId(mainMethod);
+  table.ids.push_back(mainId);
+  visited[mainId] = true;
+  for (size_t i = 0; i < table.ids.size(); i++) {
+    for (int child : indexedGraph->getChildren(table.ids[i])) {
+      if (!visited[child]) {
+        visited[child] = true;
+        table.ids.push_back(child);
+      }
+    }
+  }
+  std::sort(table.ids.begin(), table.ids.end());
+
+  size_t numberOfRows = table.ids.size();
+  table.comparisonIds.assign(numberOfRows, -1);
+  table.severity.assign(numberOfRows, .0);
+  table.childrenPreserved.assign(numberOfRows, .0);
+  table.penalty.assign(numberOfRows, .0);
+
+  for (size_t row = 0; row < numberOfRows; row++) {
+    auto match = comparisonIds.find(
+        indexedGraph->getNode(table.ids[row])->getFunctionName());
+    if (match != comparisonIds.end()) {
+      table.comparisonIds[row] = match->second;
+    }
+  }
 
-  std::for_each(
-      compareAgainst.begin(), compareAgainst.end(),
-      [this](const CgNodePtr n) { this->getInclusiveAndChildrenRuntime(n); });
+  // RN: every row only writes its own node and its own cells
+  parallelFor(numberOfRows, [this](size_t row) {
+    auto node = indexedGraph->getNode(table.ids[row]);
 
-  workQ.clear();
+    std::map<CgNodePtr, double> dominance = buildDominanceMap(node);
+    table.severity[row] = buildSeverityMap(node)[node];
 
-  // Fill the set of nodes to iterate over for comparison
-  bool collectInfoForComparingProfileOnly(false);
-  if (collectInfoForComparingProfileOnly) {
-    for (auto iter = compareAgainst.begin(); iter != compareAgainst.end();
-         ++iter) {
-      if (workQ.find(*iter) == workQ.end())
-        workQ.insert(*iter);
+    if (table.comparisonIds[row] >= 0) {
+      table.childrenPreserved[row] = childrenPreserved(
+          node, indexedComparison->getNode(table.comparisonIds[row]));
+    } else {
+      // This is the case where we lost a node!
+      for (const auto &d : dominance) {
+        table.penalty[row] += d.second;
+      }
     }
-  } else {
-    prepareList(workQ, mainMethod);
-  }
+  }, numberOfThreads);
 
-  // compute dominance and severity
-  for (const auto &n : workQ) {
-    std::map<CgNodePtr, double> innerDomMap = buildDominanceMap(n);
-    std::map<CgNodePtr, double> innerSevMap = buildSeverityMap(n);
-    domMap.insert(innerDomMap.begin(), innerDomMap.end());
-    sevMap.insert(innerSevMap.begin(), innerSevMap.end());
+  sevMap.clear();
+  for (size_t row = 0; row < numberOfRows; row++) {
+    sevMap[indexedGraph->getNode(table.ids[row])] = table.severity[row];
   }
 }
 
 void ProximityMeasureEstimatorPhase::printReport() {
   std::cout << "==== ProximityMeasure Reporter ====\n";
-  std::cerr << "Running estimation" << std::endl;
-  long numFuncsFull = graph->size();
-  long numFuncsOther = compareAgainst.size();
-  std::cout << numFuncsFull / numFuncsOther
-            << "\% of the originally recorded functions preserved" << std::endl;
+  if (table.ids.empty()) {
+    std::cerr << "No functions compared, not providing estimation" << std::endl;
+    return;
+  }
 
-  // calculate penalty for not existing nodes
-  double penalty = 0.0;
+  size_t numFuncsPreserved =
+      std::count_if(table.comparisonIds.begin(), table.comparisonIds.end(),
+                    [](int id) { return id >= 0; });
+  std::cout << 100.0 * numFuncsPreserved / table.ids.size()
+            << "\% of the originally recorded functions preserved" << std::endl;
 
   // According to our definition nodes do only add penalty if paths to those
   // nodes are no longer reconstructible
-  std::set<CgNodePtr> penaltyNodes;
-
-  for_each(graph->begin(), graph->end(),
-           [this, &penalty, &penaltyNodes](const CgNodePtr &n) {
-
-             CgNodePtrSet::iterator start = std::find_if(
-                 compareAgainst.begin(), compareAgainst.end(),
-                 [n](const CgNodePtr &ptr) { return ptr->isSameFunction(n); });
-
-             if (start == compareAgainst.end()) {
-               penaltyNodes.insert(n);
-               // This is the case where we lost a node!
-               for (const auto &c : n->getChildNodes())
-                 penalty += n->getDominance(c);
-             }
-           });
-
-  //	for(const auto &pn : penaltyNodes){
-  //		std::cout << pn->getFunctionName().substr(0,50) << "...\n";
-  //	}
-  //	std::cout << std::endl;
-
+  double penalty =
+      std::accumulate(table.penalty.begin(), table.penalty.end(), 0.0);
   std::cout << "Overall penalty: " << penalty << std::endl;
 
-  /**
-   * We try to find a good severity normalization here. That is a function that
-   * indicates whether it makes sense to capture the function using
-   * instrumentation. Especially this should give an indication whether or not
-   * the function is too small to instrument or too large to use plain
-   * instrumentation.
-   * TODO: develop a good function/metric/heuristic which determines which
-   * functions are interesting in that sense.
-   * TODO: implement something that tells you about the probe distribution.
-   */
-  typedef std::pair<CgNodePtr, double> sevListValT;
-  std::vector<sevListValT> severityList(sevMap.size());
-  std::copy(sevMap.begin(), sevMap.end(), severityList.begin());
-  auto iter = std::max_element(severityList.begin(), severityList.end(),
-                               [](const sevListValT &a, const sevListValT &b) {
-                                 return a.second < b.second;
-                               });
-  if (iter == severityList.end()) {
-    std::cerr << "NULLPTR encountered not providing estimation" << std::endl;
-    return;
-  }
-  auto t = *iter;
-  if (t.first == nullptr) {
-    std::cerr << "NULLPTR encountered not providing estimation" << std::endl;
-    return;
-  }
-  double maxVal = t.second; // This gave weird results in the first place
-  //  maxVal = 1000; // FIXME what would be the value we normlize our data to?
+  double maxSeverity =
+      *std::max_element(table.severity.begin(), table.severity.end());
+  writeTable(maxSeverity);
+  std::cout << "Per function metrics written to " << config->outputPath
+            << "/proximity-" << config->appName << ".tsv" << std::endl;
+}
 
-  std::for_each(severityList.begin(), severityList.end(),
-                [maxVal](sevListValT &elem) {
-                  double curNormalized = elem.second / maxVal;
-                  elem.second = std::log(10 * curNormalized) +
+/**
+ * We try to find a good severity normalization here. That is a function that
+ * indicates whether it makes sense to capture the function using
+ * instrumentation. Especially this should give an indication whether or not
+ * the function is too small to instrument or too large to use plain
+ * instrumentation.
+ * TODO: develop a good function/metric/heuristic which determines which
+ * functions are interesting in that sense.
+ * TODO: implement something that tells you about the probe distribution.
+ */
+void ProximityMeasureEstimatorPhase::writeTable(double maxSeverity) {
+  std::string tableFilename =
+      config->outputPath + "/proximity-" + config->appName + ".tsv";
+  std::ofstream outfile(tableFilename, std::ofstream::out);
+
+  outfile << "function\tpreserved\tinclusiveRuntime\tcomparedInclusiveRuntime"
+          << "\tseverity\tnormalizedSeverity\tchildrenPreserved\tpenalty"
+          << std::endl;
+
+  for (size_t row = 0; row < table.ids.size(); row++) {
+    int id = table.ids[row];
+    int comparisonId = table.comparisonIds[row];
+
+    double curNormalized =
+        (maxSeverity > .0) ? table.severity[row] / maxSeverity : .0;
+    double normalizedSeverity = std::log(10 * curNormalized) +
                                 std::log(10 * curNormalized) - curNormalized;
-                });
-
-	std::sort(severityList.begin(), severityList.end(),
-            [](const sevListValT &a, const sevListValT &b) {
-              return a.second > b.second;
-            });
-
-	std::cout << "Severity List (sorted): \n";
-  int numEntriesShown = 0;
-  for (const auto &p : severityList) {
-    if (p.second > -1) {
-      std::cout << p.first->getFunctionName().substr(0, 50)
-                << "...: " << p.second;
-      if (getCorrespondingComparisonNode(p.first) != nullptr) {
-        std::cout << "  \t[Preserved: yes]\n";
-      } else {
-        std::cout << "  \t[Preserved: no]\n";
-      }
-      numEntriesShown++;
-    }
+
+    outfile << indexedGraph->getNode(id)->getFunctionName() << "\t"
+            << (comparisonId >= 0 ? "yes" : "no") << "\t"
+            << inclusiveRuntimes[id] << "\t"
+            << (comparisonId >= 0 ? comparisonInclusiveRuntimes[comparisonId]
+                                  : .0)
+            << "\t" << table.severity[row] << "\t" << normalizedSeverity
+            << "\t" << table.childrenPreserved[row] << "\t"
+            << table.penalty[row] << std::endl;
   }
-  std::cout << "Showing " << numEntriesShown
-            << " with value > -1 from total of " << severityList.size()
-            << std::endl;
 }
 
 double
 ProximityMeasureEstimatorPhase::childrenPreservedMetric(CgNodePtr origFunc) {
+  loadComparisonProfile();
 
   std::set<CgNodePtr> worklist;
   prepareList(worklist, origFunc);
@@ -167,22 +199,16 @@ ProximityMeasureEstimatorPhase::childrenPreservedMetric(CgNodePtr origFunc) {
 // returns the CgNode with the same function as node
 CgNodePtr ProximityMeasureEstimatorPhase::getCorrespondingComparisonNode(
     const CgNodePtr node) {
-  for (auto fNode = compareAgainst.begin(); fNode != compareAgainst.end();
-       ++fNode) {
-
-    CgNodePtr funcNode = *fNode;
-
-    if (node->isSameFunction(funcNode)) {
-      return funcNode;
-    }
+  auto match = comparisonIds.find(node->getFunctionName());
+  if (match == comparisonIds.end()) {
+    return nullptr;
   }
-  return nullptr;
+  return indexedComparison->getNode(match->second);
 }
 
 double ProximityMeasureEstimatorPhase::portionOfRuntime(CgNodePtr node) {
 
   std::pair<double, double> runtime = getInclusiveAndChildrenRuntime(node);
-  // std::pair<double, double> runtime(1.0, 1.0);
 
   CgNodePtr compNode = getCorrespondingComparisonNode(node);
   if (compNode == nullptr) {
@@ -211,36 +237,28 @@ ProximityMeasureEstimatorPhase::buildDominanceMap(CgNodePtr node) {
   // we build a map from CgNodePtr to double vals
   std::map<CgNodePtr, double> dominance;
 
-  std::set<CgNodePtr> worklist;
-
-  prepareListOneLevel(worklist, node);
-  double rt = node->getInclusiveRuntimeInSeconds();
-  for (const auto &c : worklist) {
+  double rt = getInclusiveAndChildrenRuntime(node).first;
+  for (const auto &c : node->getChildNodes()) {
     if (c == node) {
       continue;
     }
     unsigned long long numCalls = c->getNumberOfCalls(node);
     unsigned long long totalNumberOfCalls =
         c->getNumberOfCallsWithCurrentEdges();
-    if (numCalls == 0 || totalNumberOfCalls == 0) {
-      node->setDominance(c, .0);
-      continue;
-    }
-    if ((numCalls / totalNumberOfCalls) == 0) {
-      node->setDominance(c, .0);
-      continue;
-    }
-
-    // add a little eps to the runtime in case it is 0.0
-    double rtis = c->getInclusiveRuntimeInSeconds() + 1e-16;
-    double partRTIS = (double(numCalls / totalNumberOfCalls) * (rtis));
-    double v = rt * partRTIS;
-
-    if (v == std::numeric_limits<double>::infinity()) {
-      node->setDominance(c, .0);
-    } else {
-      node->setDominance(c, v);
+    double v = .0;
+    if (numCalls != 0 && totalNumberOfCalls != 0 &&
+        (numCalls / totalNumberOfCalls) != 0) {
+      // add a little eps to the runtime in case it is 0.0
+      double rtis = getInclusiveAndChildrenRuntime(c).first + 1e-16;
+      double partRTIS = (double(numCalls / totalNumberOfCalls) * (rtis));
+      v = rt * partRTIS;
+
+      if (v == std::numeric_limits<double>::infinity()) {
+        v = .0;
+      }
     }
+    node->setDominance(c, v);
+    dominance[c] = v;
   }
   return dominance;
 }
@@ -257,8 +275,6 @@ ProximityMeasureEstimatorPhase::buildSeverityMap(CgNodePtr node) {
     return severityMap;
   }
   double rtPerCall = rt / totalNumberOfCalls;
-  // std::cout << "Runtime per call for " <<
-  // node->getFunctionName().substr(0,50) << "...: " << rtPerCall << std::endl;
   double probeCost = 1e-6; // FIXME have a real value here!
   double v = rtPerCall / probeCost;
 
@@ -266,23 +282,22 @@ ProximityMeasureEstimatorPhase::buildSeverityMap(CgNodePtr node) {
   return severityMap;
 }
 
+/** looks the node up in the graph it belongs to, the inclusive runtimes are precomputed */
 std::pair<double, double>
 ProximityMeasureEstimatorPhase::getInclusiveAndChildrenRuntime(CgNodePtr node) {
-  std::set<CgNodePtr> worklist;
-  prepareList(worklist, node);
-
   double runtimeInSeconds = node->getRuntimeInSeconds();
-  // the init value is -runtimeInSeconds, because worklist contains "node"
-  // which we don't want to include in the summation
-  double runtimeSumOfChildrenInSeconds =
-      std::accumulate(worklist.begin(), worklist.end(), -runtimeInSeconds,
-                      [](const double &a, const CgNodePtr &b) {
-                        return a + b->getRuntimeInSeconds();
-                      });
-
-  runtimeInSeconds += runtimeSumOfChildrenInSeconds;
-  node->setInclusiveRuntimeInSeconds(runtimeInSeconds);
-  return std::make_pair(runtimeInSeconds, runtimeSumOfChildrenInSeconds);
+
+  int id = indexedGraph ? indexedGraph->getId(node) : -1;
+  if (id >= 0) {
+    return std::make_pair(inclusiveRuntimes[id],
+                          inclusiveRuntimes[id] - runtimeInSeconds);
+  }
+  id = indexedComparison ? indexedComparison->getId(node) : -1;
+  if (id >= 0) {
+    return std::make_pair(comparisonInclusiveRuntimes[id],
+                          comparisonInclusiveRuntimes[id] - runtimeInSeconds);
+  }
+  return std::make_pair(runtimeInSeconds, .0);
 }
 
 double ProximityMeasureEstimatorPhase::childrenPreserved(CgNodePtr orig,
@@ -306,19 +321,7 @@ void ProximityMeasureEstimatorPhase::prepareList(std::set<CgNodePtr> &worklist,
   worklist.insert(mainM);
   for (const auto n : mainM->getChildNodes()) {
     if (worklist.find(n) == worklist.end()) {
-      //		std::cout << "\n" << n->getFunctionName() << " in " <<
-      //mainM->getFunctionName() << " " << mainM->getChildNodes().size() <<
-      //std::endl;
       prepareList(worklist, n);
     }
   }
 }
-
-void ProximityMeasureEstimatorPhase::prepareListOneLevel(
-    std::set<CgNodePtr> &worklist, CgNodePtr root) {
-  worklist.insert(root);
-  for (const auto &n : root->getChildNodes()) {
-    worklist.insert(n);
-  }
-}
-
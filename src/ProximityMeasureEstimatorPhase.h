@@ -4,11 +4,25 @@
 #include "Callgraph.h"
 #include "CubeReader.h"
 #include "EstimatorPhase.h"
+#include "IndexedCallgraph.h"
+#include "ThreadPool.h"
 
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Compares the profile against the profile in filename (usually a filtered run).
+ * Both graphs are joined once by function name, the metrics are then computed
+ * in parallel over the joined nodes and written to
+ * <outputPath>/proximity-<app>.tsv, one line per function reachable from main.
+ */
 class ProximityMeasureEstimatorPhase : public EstimatorPhase {
 
 public:
-  ProximityMeasureEstimatorPhase(std::string filename);
+  ProximityMeasureEstimatorPhase(
+      std::string filename,
+      int numberOfThreads = ThreadPool::defaultNumberOfThreads());
   virtual void modifyGraph(CgNodePtr mainMethod) override;
 
   /**
@@ -35,7 +49,7 @@ public:
 
 	/**
 	 * The severity is defined as
-	 * 
+	 *
 	 * sev_{node}(child(node)) = T_i(child(node)) * calls_{node}(child(node))
 	 *
 	 */
@@ -44,9 +58,21 @@ public:
 	void printReport() override;
 
 private:
+  /** one row per function reachable from main, the columns of the output */
+  struct ComparisonTable {
+    std::vector<int> ids;
+    std::vector<int> comparisonIds; // -1 if the function is not preserved
+    std::vector<double> severity;
+    std::vector<double> childrenPreserved;
+    std::vector<double> penalty; // the dominance of the children of a lost function
+  };
+
+  /** the comparison profile is read lazily, the config is injected after construction */
+  void loadComparisonProfile();
+  void writeTable(double maxSeverity);
+
   double childrenPreserved(CgNodePtr orig, CgNodePtr filtered);
   void prepareList(std::set<CgNodePtr> &worklist, CgNodePtr mainM);
-  void prepareListOneLevel(std::set<CgNodePtr> &worklist, CgNodePtr root);
   /**
    * Returns a pair (inclusive runtime for node, accumulated runtime for
    * children(node)
@@ -54,13 +80,21 @@ private:
   std::pair<double, double> getInclusiveAndChildrenRuntime(CgNodePtr node);
   CgNodePtr getCorrespondingComparisonNode(const CgNodePtr node);
 
-  std::map<CgNodePtr, double> domMap;
   std::map<CgNodePtr, double> sevMap;
 
-
   std::string filename;
-  CallgraphManager compareAgainst;
-  std::set<CgNodePtr> workQ;
+  int numberOfThreads;
+
+  std::unique_ptr<CallgraphManager> compareAgainst;
+  std::unique_ptr<Callgraph> comparisonGraph;
+  std::unique_ptr<IndexedCallgraph> indexedComparison;
+  std::unordered_map<std::string, int> comparisonIds;
+  std::vector<double> comparisonInclusiveRuntimes;
+
+  std::unique_ptr<IndexedCallgraph> indexedGraph;
+  std::vector<double> inclusiveRuntimes;
+
+  ComparisonTable table;
 };
 
 #endif
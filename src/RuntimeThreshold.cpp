@@ -0,0 +1,102 @@
+#include "RuntimeThreshold.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
+
+namespace RuntimeThreshold {
+
+bool parse(std::string spec, Config& c) {
+	auto colon = spec.find(':');
+	if (colon == std::string::npos) {
+		return false;
+	}
+	std::string mode = spec.substr(0, colon);
+	char* end = nullptr;
+	double value = strtod(spec.c_str() + colon + 1, &end);
+
+	if (*end != '\0' || colon + 1 == spec.size() || value < 0) {
+		return false;
+	}
+	if ((mode == "percentile" || mode == "share") && value > 100) {
+		return false;
+	}
+	if (mode != "percentile" && mode != "top" && mode != "share") {
+		return false;
+	}
+	c.thresholdMode = mode;
+	c.thresholdValue = value;
+	return true;
+}
+
+double calculate(CallgraphManager& cg, const Config& c) {
+	std::vector<double> values;
+	values.reserve(cg.size());
+	for (auto node : cg) {
+		double runtime = c.thresholdExclusive ? node->getRuntimeInSeconds() : node->getInclusiveRuntimeInSeconds();
+		if (runtime > 0) {
+			values.push_back(runtime);
+		}
+	}
+	return calculate(values, c);
+}
+
+double calculate(std::vector<double> values, const Config& c) {
+	if (c.thresholdMode == "top") {
+		return topK(values, (size_t) c.thresholdValue);
+	}
+	if (c.thresholdMode == "share") {
+		return topShare(values, c.thresholdValue);
+	}
+	return percentile(values, c.thresholdValue);
+}
+
+double percentile(std::vector<double>& values, double percent) {
+	if (values.empty()) {
+		return .0;
+	}
+	size_t index = std::min(values.size() - 1, (size_t) (percent * values.size() / 100));
+	std::nth_element(values.begin(), values.begin() + index, values.end());
+	return values[index];
+}
+
+double topK(std::vector<double>& values, size_t k) {
+	if (values.empty() || k == 0) {
+		return HUGE_VAL;	// nothing is above
+	}
+	size_t index = std::min(values.size(), k) - 1;
+	std::nth_element(values.begin(), values.begin() + index, values.end(), std::greater<double>());
+	return values[index];
+}
+
+/**
+ * RN: quickselect on the share: the larger part is only kept if it already has enough of the sum,
+ * otherwise its sum is taken and the search continues in the smaller part. Expected O(n).
+ */
+double topShare(std::vector<double>& values, double percent) {
+	if (values.empty()) {
+		return .0;
+	}
+	double needed = std::accumulate(values.begin(), values.end(), .0) * percent / 100;
+
+	auto first = values.begin();
+	auto last = values.end();
+	double threshold = *std::min_element(first, last);	// if all values are needed
+	while (first != last) {
+		auto middle = first + (last - first) / 2;
+		std::nth_element(first, middle, last, std::greater<double>());
+		double upperSum = std::accumulate(first, middle + 1, .0);
+
+		if (upperSum >= needed) {
+			threshold = *middle;
+			last = middle;
+		} else {
+			needed -= upperSum;
+			first = middle + 1;
+		}
+	}
+	return threshold;
+}
+
+}
@@ -0,0 +1,32 @@
+#ifndef RUNTIMETHRESHOLD_H_
+#define RUNTIMETHRESHOLD_H_
+
+#include "CallgraphManager.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * Selects the runtime threshold of the RuntimeEstimatorPhase from the runtimes of all functions.
+ * Only functions with a positive runtime count. The modes are (see Config):
+ *   percentile:P  the runtime below which P percent of the functions are
+ *   top:K         the runtime of the K-th most expensive function
+ *   share:P       the smallest runtime such that the functions at or above it have P percent
+ *                 of the summed runtime
+ * The metric is the inclusive runtime of a function or, with thresholdExclusive, its own runtime.
+ */
+namespace RuntimeThreshold {
+
+	/** parses MODE:VALUE into the config, false if it is not valid */
+	bool parse(std::string spec, Config& c);
+
+	double calculate(CallgraphManager& cg, const Config& c);
+	double calculate(std::vector<double> values, const Config& c);
+
+	/** O(n) selection, the values are reordered */
+	double percentile(std::vector<double>& values, double percent);
+	double topK(std::vector<double>& values, size_t k);
+	double topShare(std::vector<double>& values, double percent);
+}
+
+#endif
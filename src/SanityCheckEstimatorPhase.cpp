@@ -1,47 +1,203 @@
 #include "SanityCheckEstimatorPhase.h"
 
-SanityCheckEstimatorPhase::SanityCheckEstimatorPhase() :
+std::ostream& operator<<(std::ostream& stream, const SanityCheckError& error) {
+	switch (error.kind) {
+	case SanityCheckError::UNWOUND_ON_CYCLE:
+		return stream << "unwound function is on a circle: " << error.conjunction->getFunctionName();
+	case SanityCheckError::UNWOUND_WITHOUT_STEPS:
+		return stream << "unwound function with 0 unwindSteps: " << error.conjunction->getFunctionName();
+	case SanityCheckError::REACHED_ON_MULTIPLE_PATHS:
+		return stream << "the conjunction: " << *error.conjunction
+				<< " is reached on multiple paths by: " << *error.first;
+	default:
+		return stream << "conjunction: " << *error.conjunction << " paths of " << *error.first
+				<< " and " << *error.second << " intersect";
+	}
+}
+
+SanityCheckEstimatorPhase::SanityCheckEstimatorPhase(int numberOfThreads) :
 		EstimatorPhase("SanityCheck", true),
-		numberOfErrors(0){
+		numberOfThreads(numberOfThreads) {
 }
 
 SanityCheckEstimatorPhase::~SanityCheckEstimatorPhase() {}
 
 void SanityCheckEstimatorPhase::modifyGraph(CgNodePtr mainMethod) {
 
-	for (auto node : (*graph)) {
+	IndexedCallgraph indexedGraph(*graph);
 
-		// unwound nodes are fine as they are
-		if(!CgHelper::isConjunction(node) || node->isInstrumentedConjunction()) {
+	// unwound nodes are fine as they are
+	std::vector<int> conjunctions;
+	std::vector<bool> isParentOfConjunction(indexedGraph.size(), false);
+	for (size_t id = 0; id < indexedGraph.size(); id++) {
+		auto node = indexedGraph.getNode(id);
+		if (!CgHelper::isConjunction(node) || node->isInstrumentedConjunction()) {
 			continue;
 		}
+		conjunctions.push_back(id);
+		for (int parent : indexedGraph.getParents(id)) {
+			isParentOfConjunction[parent] = true;
+		}
+	}
 
-		if (node->isUnwound()) {
-			if (CgHelper::isOnCycle(node)) {
-				std::cerr << "ERROR: unwound function is on a circle: "
-						<< node->getFunctionName() << std::endl;
-				numberOfErrors++;
-			} else {
-				continue;
-			}
+	std::vector<int> parents;
+	for (size_t id = 0; id < indexedGraph.size(); id++) {
+		if (isParentOfConjunction[id]) {
+			parents.push_back(id);
+		}
+	}
+
+	// RN: every chunk of work gets its own scratch space, a few chunks per thread balance the load
+	size_t numberOfChunks = std::max(1, numberOfThreads) * 4;
+	auto chunkRange = [numberOfChunks](size_t n, size_t chunk) {
+		return std::make_pair(n * chunk / numberOfChunks, n * (chunk + 1) / numberOfChunks);
+	};
+
+	instrumentationPaths.assign(indexedGraph.size(), std::vector<int>());
+	parallelFor(numberOfChunks, [&](size_t chunk) {
+		Scratch scratch(indexedGraph.size());
+		auto range = chunkRange(parents.size(), chunk);
+		for (size_t i = range.first; i < range.second; i++) {
+			instrumentationPaths[parents[i]] = getInstrumentationPath(indexedGraph, parents[i], scratch);
+		}
+	}, numberOfThreads);
+
+	std::vector<std::vector<SanityCheckError> > errorsPerChunk(numberOfChunks);
+	parallelFor(numberOfChunks, [&](size_t chunk) {
+		Scratch scratch(indexedGraph.size());
+		auto range = chunkRange(conjunctions.size(), chunk);
+		for (size_t i = range.first; i < range.second; i++) {
+			checkConjunction(indexedGraph, conjunctions[i], scratch, errorsPerChunk[chunk]);
+		}
+	}, numberOfThreads);
+
+	// the chunks are in id order, so the errors are ordered by conjunction
+	errors.clear();
+	for (auto& chunkErrors : errorsPerChunk) {
+		errors.insert(errors.end(), chunkErrors.begin(), chunkErrors.end());
+	}
+	instrumentationPaths.clear();
+
+	// XXX idea: check that there is no instrumentation below unwound nodes
+}
 
-			if (node->getNumberOfUnwindSteps() == 0) {
-				std::cerr << "ERROR: unwound function with 0 unwindSteps" << std::endl;
-				numberOfErrors++;
+/** same as CgHelper::getInstrumentationPath() */
+std::vector<int> SanityCheckEstimatorPhase::getInstrumentationPath(const IndexedCallgraph& indexedGraph,
+		int start, Scratch& scratch) {
+
+	unsigned mark = ++scratch.currentMark;
+	std::vector<int> path = {start};
+	scratch.mark[start] = mark;
+
+	for (size_t i = 0; i < path.size(); i++) {
+		int node = path[i];
+		if (indexedGraph.getNode(node)->isInstrumented()) {
+			continue;
+		}
+		for (int parent : indexedGraph.getParents(node)) {
+			if (scratch.mark[parent] != mark) {
+				scratch.mark[parent] = mark;
+				path.push_back(parent);
 			}
 		}
+	}
 
+	std::sort(path.begin(), path.end());
+	return path;
+}
 
+void SanityCheckEstimatorPhase::checkConjunction(const IndexedCallgraph& indexedGraph, int conjunction,
+		Scratch& scratch, std::vector<SanityCheckError>& foundErrors) {
 
-		numberOfErrors += (CgHelper::isUniquelyInstrumented(node, nullptr, true) ? 0 : 1);
-		numberOfErrors += CgHelper::uniquelyInstrumentedConjunctionTest(node, true);
+	auto node = indexedGraph.getNode(conjunction);
+	auto parents = indexedGraph.getParents(conjunction);
+
+	if (node->isUnwound()) {
+		if (!indexedGraph.isCyclic(indexedGraph.getScc(conjunction))) {
+			return;
+		}
+		foundErrors.push_back(SanityCheckError{SanityCheckError::UNWOUND_ON_CYCLE, node, nullptr, nullptr});
+		if (node->getNumberOfUnwindSteps() == 0) {
+			foundErrors.push_back(SanityCheckError{SanityCheckError::UNWOUND_WITHOUT_STEPS, node, nullptr, nullptr});
+		}
+	} else {
+		// CgHelper::isUniquelyInstrumented(): no node above the conjunction may be reached twice, i.e.,
+		// be a parent of the conjunction or of an uninstrumented node on the paths more than once
+		unsigned mark = ++scratch.currentMark;
+		auto reach = [&scratch, mark](int id) {
+			if (scratch.mark[id] != mark) {
+				scratch.mark[id] = mark;
+				scratch.value[id] = 0;
+			}
+			return ++scratch.value[id] > 1;
+		};
+
+		int reachedTwice = -1;
+		for (int parent : parents) {
+			if (reach(parent) && reachedTwice < 0) {
+				reachedTwice = parent;
+			}
+		}
+		// the paths of the parents overlap, every node is expanded once
+		for (int parent : parents) {
+			for (int id : instrumentationPaths[parent]) {
+				if (scratch.expanded[id] == mark || indexedGraph.getNode(id)->isInstrumented()) {
+					continue;
+				}
+				scratch.expanded[id] = mark;
+				for (int grandParent : indexedGraph.getParents(id)) {
+					if (reach(grandParent) && reachedTwice < 0) {
+						reachedTwice = grandParent;
+					}
+				}
+			}
+		}
+		if (reachedTwice >= 0) {
+			foundErrors.push_back(SanityCheckError{SanityCheckError::REACHED_ON_MULTIPLE_PATHS,
+					node, indexedGraph.getNode(reachedTwice), nullptr});
+		}
 	}
 
-	// XXX idea: check that there is no instrumentation below unwound nodes
+	// CgHelper::uniquelyInstrumentedConjunctionTest(): the paths of the parents must not intersect
+	unsigned mark = ++scratch.currentMark;
+	bool intersection = false;
+	for (int parent : parents) {
+		for (int id : instrumentationPaths[parent]) {
+			if (scratch.mark[id] == mark) {
+				intersection = true;
+				break;
+			}
+			scratch.mark[id] = mark;
+		}
+	}
+	if (!intersection) {
+		return;
+	}
+
+	// only compare all pairs if there is an error
+	for (auto first = parents.begin(); first != parents.end(); ++first) {
+		for (auto second = first + 1; second != parents.end(); ++second) {
+			auto& firstPath = instrumentationPaths[*first];
+			auto& secondPath = instrumentationPaths[*second];
+			auto f = firstPath.begin();
+			auto s = secondPath.begin();
+			while (f != firstPath.end() && s != secondPath.end() && *f != *s) {
+				(*f < *s) ? ++f : ++s;
+			}
+			if (f != firstPath.end() && s != secondPath.end()) {
+				foundErrors.push_back(SanityCheckError{SanityCheckError::INTERSECTING_PATHS,
+						node, indexedGraph.getNode(*first), indexedGraph.getNode(*second)});
+			}
+		}
+	}
 }
 
 void SanityCheckEstimatorPhase::printAdditionalReport() {
 	std::cout << "\t" << "SanityCheck done with "
-			<< numberOfErrors << " errors." << std::endl;
+			<< errors.size() << " errors." << std::endl;
+	if (!config->tinyReport) {
+		for (auto& error : errors) {
+			std::cout << "\t" << "ERROR: " << error << std::endl;
+		}
+	}
 }
-
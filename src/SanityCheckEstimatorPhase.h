@@ -1,25 +1,64 @@
-
 #ifndef SANITYCHECKESTIMATORPHASE_H_
 #define SANITYCHECKESTIMATORPHASE_H_
 
 #include <queue>
+#include <vector>
 
 #include "EstimatorPhase.h"
 #include "CgHelper.h"
+#include "IndexedCallgraph.h"
+#include "ThreadPool.h"
+
+struct SanityCheckError {
+	enum Kind {
+		UNWOUND_ON_CYCLE,
+		UNWOUND_WITHOUT_STEPS,
+		REACHED_ON_MULTIPLE_PATHS,	// first is the node that is reached twice
+		INTERSECTING_PATHS			// first & second are the parents with intersecting paths
+	};
+
+	Kind kind;
+	CgNodePtr conjunction;
+	CgNodePtr first;
+	CgNodePtr second;
+};
+
+std::ostream& operator<<(std::ostream& stream, const SanityCheckError& error);
 
 /**
  * Does not modify the graph.
  * Only does a full sanity checks for instrumentation & unwind.
+ * RN: The instrumentation path of every parent of a conjunction is computed once (sorted node ids)
+ * and shared by all its conjunctions, the conjunctions are checked in parallel.
+ * The errors are collected and listed in the report.
  */
 class SanityCheckEstimatorPhase : public EstimatorPhase {
 public:
-	SanityCheckEstimatorPhase();
+	SanityCheckEstimatorPhase(int numberOfThreads = ThreadPool::defaultNumberOfThreads());
 	~SanityCheckEstimatorPhase();
 	/** does NOT modify the graph */
 	void modifyGraph(CgNodePtr mainMethod);
 
+	const std::vector<SanityCheckError>& getErrors() const { return errors; }
+
 private:
-	int numberOfErrors;
+	/** scratch space of one thread, a node is marked iff its mark equals the current mark */
+	struct Scratch {
+		std::vector<unsigned> mark;
+		std::vector<unsigned> expanded;
+		std::vector<int> value;
+		unsigned currentMark;
+
+		Scratch(size_t size) : mark(size, 0), expanded(size, 0), value(size, 0), currentMark(0) {}
+	};
+
+	std::vector<int> getInstrumentationPath(const IndexedCallgraph& indexedGraph, int start, Scratch& scratch);
+	void checkConjunction(const IndexedCallgraph& indexedGraph, int conjunction, Scratch& scratch,
+			std::vector<SanityCheckError>& foundErrors);
+
+	int numberOfThreads;
+	std::vector<std::vector<int> > instrumentationPaths;	// per node id, only for parents of conjunctions
+	std::vector<SanityCheckError> errors;
 
 	void printAdditionalReport();
 };
@@ -0,0 +1,188 @@
+#include "SyntheticCallgraph.h"
+
+#include "IPCGEstimatorPhase.h"
+#include "RuntimeThreshold.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+#include <sys/resource.h>	// getrusage()
+#include <unistd.h>
+
+namespace {
+
+	typedef std::chrono::steady_clock Clock;
+
+	double secondsSince(Clock::time_point start) {
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	std::string nameOf(size_t id) {
+		return (id == 0) ? "main" : "f" + std::to_string(id);
+	}
+
+	/** onNode(id, runtime) for every node, then onCallEdge(caller, id, calls) for every caller of that node */
+	template<typename NodeCallback, typename EdgeCallback>
+	void generateGraph(size_t numberOfNodes, NodeCallback onNode, EdgeCallback onCallEdge) {
+		std::mt19937_64 random(42);
+		std::exponential_distribution<double> runtime(1e4);	// 100 us on average
+		std::uniform_int_distribution<unsigned long long> calls(1, 1000);
+		std::uniform_int_distribution<int> furtherCallers(0, 3);
+
+		std::vector<size_t> callers;
+		for (size_t id = 0; id < numberOfNodes; id++) {
+			onNode(id, runtime(random));
+			if (id == 0) {
+				continue;
+			}
+
+			callers.assign(1, std::uniform_int_distribution<size_t>(0, id - 1)(random));
+			for (int i = furtherCallers(random); i > 0; i--) {
+				// RN: callers with a larger id close cycles
+				size_t caller = std::uniform_int_distribution<size_t>(0, numberOfNodes - 1)(random);
+				if (caller != id && std::find(callers.begin(), callers.end(), caller) == callers.end()) {
+					callers.push_back(caller);
+				}
+			}
+			for (auto caller : callers) {
+				onCallEdge(caller, id, calls(random));
+			}
+		}
+	}
+
+	size_t currentResidentBytes() {
+		std::ifstream statm("/proc/self/statm");
+		size_t pages = 0;
+		size_t residentPages = 0;
+		statm >> pages >> residentPages;
+		return residentPages * sysconf(_SC_PAGESIZE);
+	}
+
+	size_t peakResidentBytes() {
+		struct rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		return usage.ru_maxrss * 1024;
+	}
+
+	/** runs the phase on the graph, returns the number of instrumented nodes & their calls */
+	std::pair<size_t, unsigned long long> runPhase(EstimatorPhase* phase, Callgraph& graph, Config& c) {
+		TRACE_ZONE(phase->getName());
+
+		for (auto node : graph) {
+			node->reset();
+		}
+		phase->injectConfig(&c);
+		phase->setGraph(&graph);
+		phase->modifyGraph(graph.findMain());
+
+		std::pair<size_t, unsigned long long> instrumented(0, 0);
+		for (auto node : graph) {
+			if (node->isInstrumented()) {
+				instrumented.first++;
+				instrumented.second += node->getNumberOfCalls();
+			}
+		}
+		return instrumented;
+	}
+}
+
+namespace SyntheticCallgraph {
+
+	void generate(size_t numberOfNodes, CallgraphManager& cg) {
+		TRACE_ZONE("SyntheticCallgraph::generate");
+
+		std::mt19937_64 random(7);
+		std::uniform_int_distribution<int> statements(1, 300);
+		generateGraph(numberOfNodes,
+				[&cg, &random, &statements](size_t id, double runtime) {
+					auto node = cg.findOrCreateNode(nameOf(id));	// it exists if a caller closes a cycle
+					node->setRuntimeInSeconds(runtime);
+					node->setNumberOfStatements(statements(random));
+				},
+				[&cg](size_t caller, size_t id, unsigned long long calls) {
+					cg.putEdge(nameOf(caller), std::string(), 0, nameOf(id), calls, .0);
+				});
+		for (auto node : cg) {
+			node->updateDynamicNodeAttributes();
+		}
+	}
+
+	int run(size_t numberOfNodes) {
+
+		std::cout << "Synthetic call graph with " << numberOfNodes << " nodes" << std::endl;
+
+		Config c;
+		c.appName = "synthetic";
+		CallgraphManager cg(&c);
+
+		auto startTime = Clock::now();
+		size_t residentBefore = currentResidentBytes();
+		generate(numberOfNodes, cg);
+		Callgraph graph = cg.getCallgraph(&cg);
+		size_t residentBytes = currentResidentBytes() - residentBefore;
+		double buildSeconds = secondsSince(startTime);
+
+		startTime = Clock::now();
+		size_t numberOfEdges = 0;
+		size_t numberOfConjunctions = 0;
+		CgNodePtrUnorderedSet reachable;
+		std::vector<CgNodePtr> workList(1, graph.findMain());
+		reachable.insert(workList.back());
+		while (!workList.empty()) {
+			auto node = workList.back();
+			workList.pop_back();
+			numberOfEdges += node->getChildNodes().size();
+			numberOfConjunctions += node->getParentNodes().size() > 1;
+			for (auto child : node->getChildNodes()) {
+				if (reachable.insert(child).second) {
+					workList.push_back(child);
+				}
+			}
+		}
+		double traversalSeconds = secondsSince(startTime);
+
+		// RN: see RuntimeThreshold.h for the default threshold
+		std::vector<double> runtimes;
+		runtimes.reserve(graph.size());
+		for (auto node : graph) {
+			runtimes.push_back(node->getRuntimeInSeconds());
+		}
+		double threshold = RuntimeThreshold::calculate(runtimes, c);
+
+		startTime = Clock::now();
+		RuntimeEstimatorPhase runtimePhase(threshold);
+		auto runtimeInstrumented = runPhase(&runtimePhase, graph, c);
+		double runtimeSeconds = secondsSince(startTime);
+
+		startTime = Clock::now();
+		StatementCountEstimatorPhase statementPhase(150);
+		auto statementInstrumented = runPhase(&statementPhase, graph, c);
+		double statementSeconds = secondsSince(startTime);
+
+		std::cout << std::setprecision(4)
+				<< "    " << "edges: " << numberOfEdges << " | conjunctions: " << numberOfConjunctions
+				<< " | reachable from main: " << reachable.size() << std::endl
+				<< "    " << "CgNode: " << sizeof(CgNode) << " bytes | resident: "
+				<< (double) residentBytes / numberOfNodes << " bytes per node, with edges & names"
+				<< " | peak: " << peakResidentBytes() / (1024 * 1024) << " MB" << std::endl
+				<< "    " << "build: " << buildSeconds << " s | traversal: " << traversalSeconds << " s" << std::endl
+				<< "    " << runtimePhase.getName() << ": " << runtimeSeconds << " s, " << runtimeInstrumented.first
+				<< " functions with " << runtimeInstrumented.second << " calls instrumented" << std::endl
+				<< "    " << statementPhase.getName() << ": " << statementSeconds << " s, " << statementInstrumented.first
+				<< " functions with " << statementInstrumented.second << " calls instrumented" << std::endl;
+
+		// RN: the edges are shared_ptr cycles, the nodes are only freed without them
+		for (auto node : graph) {
+			for (auto child : CgNodePtrSet(node->getChildNodes())) {
+				node->removeChildNode(child);
+				child->removeParentNode(node);
+			}
+		}
+		return EXIT_SUCCESS;
+	}
+}
@@ -0,0 +1,23 @@
+#ifndef SYNTHETICCALLGRAPH_H_
+#define SYNTHETICCALLGRAPH_H_
+
+#include "CallgraphManager.h"
+
+/**
+ * Random call graphs of a given size to measure the memory & time of the tool on graphs with
+ * millions of functions, without such a profile at hand. Node 0 is main, every other node has
+ * a caller with a smaller id (so it is reachable from main) and up to three random further callers.
+ */
+namespace SyntheticCallgraph {
+
+	/** the same graph for the same number of nodes */
+	void generate(size_t numberOfNodes, CallgraphManager& cg);
+
+	/**
+	 * Builds a graph of numberOfNodes CgNodes and runs a traversal, the RuntimeEstimatorPhase
+	 * and the StatementCountEstimatorPhase on it. Reports the memory per node & the times.
+	 */
+	int run(size_t numberOfNodes);
+}
+
+#endif
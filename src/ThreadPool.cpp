@@ -0,0 +1,94 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+
+ThreadPool::ThreadPool(int numberOfThreads) :
+		unfinishedTasks(0),
+		stopping(false) {
+
+	for (int i = 0; i < std::max(numberOfThreads, 1); i++) {
+		workers.push_back(std::thread(&ThreadPool::work, this));
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	taskAvailable.notify_all();
+
+	for (auto& worker : workers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		tasks.push(task);
+		unfinishedTasks++;
+	}
+	taskAvailable.notify_one();
+}
+
+void ThreadPool::waitForAll() {
+	std::unique_lock<std::mutex> lock(mutex);
+	allTasksDone.wait(lock, [this]() { return unfinishedTasks == 0; });
+}
+
+int ThreadPool::defaultNumberOfThreads() {
+	unsigned int hardwareThreads = std::thread::hardware_concurrency();
+	return hardwareThreads > 0 ? hardwareThreads : 1;
+}
+
+void ThreadPool::work() {
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			taskAvailable.wait(lock, [this]() { return stopping || !tasks.empty(); });
+
+			if (tasks.empty()) {
+				return;	// stopping
+			}
+			task = tasks.front();
+			tasks.pop();
+		}
+
+		task();
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (--unfinishedTasks == 0) {
+			allTasksDone.notify_all();
+		}
+	}
+}
+
+void parallelFor(size_t n, std::function<void(size_t)> body, int numberOfThreads) {
+
+	if (numberOfThreads <= 1 || n <= 1) {
+		for (size_t i = 0; i < n; i++) {
+			body(i);
+		}
+		return;
+	}
+
+	std::atomic<size_t> next(0);
+	auto worker = [&]() {
+		for (size_t i = next++; i < n; i = next++) {
+			body(i);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (size_t t = 1; t < std::min<size_t>(numberOfThreads, n); t++) {
+		threads.push_back(std::thread(worker));
+	}
+	worker();	// the calling thread works as well
+
+	for (auto& thread : threads) {
+		thread.join();
+	}
+}
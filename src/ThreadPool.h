@@ -0,0 +1,45 @@
+#ifndef THREADPOOL_H_
+#define THREADPOOL_H_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed number of worker threads processing a shared task queue.
+ */
+class ThreadPool {
+public:
+	ThreadPool(int numberOfThreads = defaultNumberOfThreads());
+	~ThreadPool();
+
+	void enqueue(std::function<void()> task);
+	/** blocks until all enqueued tasks are finished */
+	void waitForAll();
+
+	int size() const { return workers.size(); }
+
+	static int defaultNumberOfThreads();
+
+private:
+	void work();
+
+	std::vector<std::thread> workers;
+	std::queue<std::function<void()> > tasks;
+
+	std::mutex mutex;
+	std::condition_variable taskAvailable;
+	std::condition_variable allTasksDone;
+
+	int unfinishedTasks;
+	bool stopping;
+};
+
+/** runs body(i) for all i in [0, n), the order is not defined */
+void parallelFor(size_t n, std::function<void(size_t)> body,
+		int numberOfThreads = ThreadPool::defaultNumberOfThreads());
+
+#endif
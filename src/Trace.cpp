@@ -0,0 +1,138 @@
+#include "Trace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+	struct Event {
+		const char* name;
+		std::string detail;
+		long long startNanos;
+		long long durationNanos;
+	};
+
+	/** written by its own thread only, read by Trace::write() after the threads are done */
+	struct Buffer {
+		int threadId;
+		std::vector<Event> events;
+		std::unordered_set<std::string> names;	// the runtime names, the set keeps their addresses
+	};
+
+	std::mutex buffersMutex;
+	std::vector<std::shared_ptr<Buffer> > buffers;
+
+	std::string traceFilePath;
+	std::chrono::steady_clock::time_point traceStartTime;
+
+	Buffer& getBuffer() {
+		// RN: the list keeps the buffer of a finished thread (batch worker) alive until the trace is written
+		static thread_local std::shared_ptr<Buffer> buffer;
+		if (!buffer) {
+			buffer = std::make_shared<Buffer>();
+			std::lock_guard<std::mutex> lock(buffersMutex);
+			buffer->threadId = buffers.size() + 1;
+			buffers.push_back(buffer);
+		}
+		return *buffer;
+	}
+
+	long long nanosSinceStart(std::chrono::steady_clock::time_point time) {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(time - traceStartTime).count();
+	}
+
+	std::string escapeJson(const std::string& s) {
+		std::string escaped;
+		for (char c : s) {
+			if (c == '"' || c == '\\') {
+				escaped += '\\';
+				escaped += c;
+			} else if ((unsigned char) c < 0x20) {
+				char hex[8];
+				snprintf(hex, sizeof(hex), "\\u%04x", c);
+				escaped += hex;
+			} else {
+				escaped += c;
+			}
+		}
+		return escaped;
+	}
+
+	/** the trace format has microseconds */
+	std::string micros(long long nanos) {
+		char buffer[32];
+		snprintf(buffer, sizeof(buffer), "%lld.%03lld", nanos / 1000, nanos % 1000);
+		return buffer;
+	}
+}
+
+namespace Trace {
+
+	std::atomic<bool> enabled(false);
+
+	bool enable(std::string filePath) {
+		if (!std::ofstream(filePath, std::ofstream::out)) {
+			std::cerr << "Error: can not write trace " << filePath << std::endl;
+			return false;
+		}
+		traceFilePath = filePath;
+		traceStartTime = std::chrono::steady_clock::now();
+		getBuffer();	// the thread that enables the trace is the first track
+		enabled.store(true);
+
+		// also written if the tool exits on an error
+		std::atexit(write);
+		return true;
+	}
+
+	void write() {
+		if (!isEnabled()) {
+			return;
+		}
+		std::ofstream outfile(traceFilePath, std::ofstream::out);
+
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		outfile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl;
+		bool first = true;
+		for (auto& buffer : buffers) {
+			outfile << (first ? "" : ",\n") << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId
+					<< ",\"name\":\"thread_name\",\"args\":{\"name\":\""
+					<< (buffer->threadId == 1 ? std::string("main") : "thread " + std::to_string(buffer->threadId))
+					<< "\"}}";
+			first = false;
+
+			for (auto& event : buffer->events) {
+				outfile << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId
+						<< ",\"ts\":" << micros(event.startNanos) << ",\"dur\":" << micros(event.durationNanos)
+						<< ",\"name\":\"" << escapeJson(event.name) << "\"";
+				if (!event.detail.empty()) {
+					outfile << ",\"args\":{\"detail\":\"" << escapeJson(event.detail) << "\"}";
+				}
+				outfile << "}";
+			}
+		}
+		outfile << "\n]}" << std::endl;
+	}
+
+	const char* Zone::internName(const std::string& name) {
+		return getBuffer().names.insert(name).first->c_str();
+	}
+
+	void Zone::begin(const char* name, const std::string& detail) {
+		auto& events = getBuffer().events;
+		eventIndex = events.size();
+		events.push_back(Event{name, detail, nanosSinceStart(std::chrono::steady_clock::now()), 0});
+	}
+
+	void Zone::end() {
+		auto& event = getBuffer().events[eventIndex];
+		event.durationNanos = nanosSinceStart(std::chrono::steady_clock::now()) - event.startNanos;
+	}
+}
@@ -0,0 +1,69 @@
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <atomic>
+#include <string>
+
+/**
+ * Self profiling of the tool, enabled with --trace FILE. A Zone measures its scope and is written
+ * as a complete event of the Chrome trace format, so the file can be opened in chrome://tracing
+ * or ui.perfetto.dev. Every thread has its own event buffer, batch jobs show up as separate tracks.
+ * A disabled zone costs one relaxed load, so zones can be placed in the CgHelper traversals as well.
+ */
+namespace Trace {
+
+	extern std::atomic<bool> enabled;
+
+	/** the events are written to filePath at exit, returns false if the file can not be opened */
+	bool enable(std::string filePath);
+	/** writes the events recorded so far, the threads of a batch run have to be joined already */
+	void write();
+
+	inline bool isEnabled() {
+		return enabled.load(std::memory_order_relaxed);
+	}
+
+	class Zone {
+	public:
+		/** the name has to outlive the trace (a string literal) */
+		explicit Zone(const char* name) : eventIndex(-1) {
+			if (isEnabled()) {
+				begin(name, std::string());
+			}
+		}
+		/** detail is shown in the args of the event, e.g., the file that is read */
+		Zone(const char* name, const std::string& detail) : eventIndex(-1) {
+			if (isEnabled()) {
+				begin(name, detail);
+			}
+		}
+		/** for names that are only known at runtime, e.g., the phase names */
+		explicit Zone(const std::string& name, const std::string& detail = std::string()) : eventIndex(-1) {
+			if (isEnabled()) {
+				begin(internName(name), detail);
+			}
+		}
+		~Zone() {
+			if (eventIndex >= 0) {
+				end();
+			}
+		}
+
+		Zone(const Zone&) = delete;
+		Zone& operator=(const Zone&) = delete;
+
+	private:
+		static const char* internName(const std::string& name);
+		void begin(const char* name, const std::string& detail);
+		void end();
+
+		long long eventIndex;	// in the buffer of the thread, -1 if the zone is disabled
+	};
+}
+
+#define TRACE_CONCAT_(a, b) a ## b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+/** a zone for the rest of the enclosing scope */
+#define TRACE_ZONE(...) Trace::Zone TRACE_CONCAT(traceZone, __LINE__)(__VA_ARGS__)
+
+#endif
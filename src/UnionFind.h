@@ -0,0 +1,47 @@
+#ifndef UNIONFIND_H_
+#define UNIONFIND_H_
+
+#include <numeric>
+#include <utility>
+#include <vector>
+
+/**
+ * Disjoint sets over the ids [0, n) with union by size and path halving.
+ */
+class UnionFind {
+public:
+	UnionFind(size_t n) : parent(n), setSize(n, 1) {
+		std::iota(parent.begin(), parent.end(), 0);
+	}
+
+	int find(int id) {
+		while (parent[id] != id) {
+			parent[id] = parent[parent[id]];
+			id = parent[id];
+		}
+		return id;
+	}
+
+	/** false if both ids already are in the same set */
+	bool unite(int a, int b) {
+		a = find(a);
+		b = find(b);
+		if (a == b) {
+			return false;
+		}
+		if (setSize[a] < setSize[b]) {
+			std::swap(a, b);
+		}
+		parent[b] = a;
+		setSize[a] += setSize[b];
+		return true;
+	}
+
+	int getSetSize(int id) { return setSize[find(id)]; }
+
+private:
+	std::vector<int> parent;
+	std::vector<int> setSize;
+};
+
+#endif
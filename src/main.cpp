@@ -1,10 +1,18 @@
 #include <fstream>
+#include <sstream>
+#include <cctype>
 #include <cstdlib>
+#include <algorithm>
 #include <vector>
 
+#include "BatchDriver.h"
+#include "Calibration.h"
 #include "CubeReader.h"
 #include "DotReader.h"
 #include "IPCGReader.h"
+#include "RuntimeThreshold.h"
+#include "SyntheticCallgraph.h"
+#include "Trace.h"
 
 #include "Callgraph.h"
 
@@ -13,8 +21,13 @@
 #include "NodeBasedOptimumEstimatorPhase.h"
 #include "ProximityMeasureEstimatorPhase.h"
 #include "IPCGEstimatorPhase.h"
+#include "OverheadBudgetEstimatorPhase.h"
+#include "BallLarusEstimatorPhase.h"
+#include "CallsiteInstrumentationEstimatorPhase.h"
+#include "ContextTreeEstimatorPhase.h"
+#include "PlanEmitter.h"
 
-void registerEstimatorPhases(CallgraphManager& cg, Config* c, int Isipcg,float threshold_Runtime) {
+void registerEstimatorPhases(CallgraphManager& cg, Config* c, int Isipcg, double threshold_Runtime) {
     cg.registerEstimatorPhase(new OverheadCompensationEstimatorPhase(c->nanosPerHalfProbe));
     cg.registerEstimatorPhase(new RemoveUnrelatedNodesEstimatorPhase(true, false));         // remove unrelated
 
@@ -25,6 +38,30 @@ void registerEstimatorPhases(CallgraphManager& cg, Config* c, int Isipcg,float t
         std::cout << "New threshold runtime for profiling:"<<threshold_Runtime<<std::endl;
         cg.registerEstimatorPhase(new RuntimeEstimatorPhase(threshold_Runtime));
        // cg.registerEstimatorPhase(new RuntimeEstimatorPhase(0));
+        if (c->overheadBudgetPercent > .0) {
+            cg.registerEstimatorPhase(new ResetEstimatorPhase());
+            cg.registerEstimatorPhase(new OverheadBudgetEstimatorPhase(c->overheadBudgetPercent));
+        }
+        if (c->ballLarus) {
+            cg.registerEstimatorPhase(new ResetEstimatorPhase());
+            cg.registerEstimatorPhase(new BallLarusEstimatorPhase());
+        }
+        if (c->callsites) {
+            cg.registerEstimatorPhase(new ResetEstimatorPhase());
+            cg.registerEstimatorPhase(new RuntimeEstimatorPhase(threshold_Runtime), true);
+            cg.registerEstimatorPhase(new CallsiteInstrumentationEstimatorPhase(cg.getCallsiteGraph(), threshold_Runtime));
+        }
+        if (c->nodeBasedOptimum) {
+            cg.registerEstimatorPhase(new ResetEstimatorPhase());
+            cg.registerEstimatorPhase(new OptimalNodeBasedEstimatorPhase(c->optimumThreads,
+                    c->optimumSeconds, c->optimumSteps, c->optimumCheckpoint, c->optimumClusters));
+        }
+        if (c->contextTree && cg.getContextTree()) {
+            cg.registerEstimatorPhase(new ResetEstimatorPhase());
+            cg.registerEstimatorPhase(new ContextInstrumentationEstimatorPhase(cg.getContextTree(), threshold_Runtime));
+            cg.registerEstimatorPhase(new ResetEstimatorPhase());
+            cg.registerEstimatorPhase(new ContextUnwindEstimatorPhase(cg.getContextTree(), threshold_Runtime));
+        }
     }
     else{
         cg.registerEstimatorPhase(new StatementCountEstimatorPhase(150));
@@ -82,36 +119,55 @@ bool stringEndsWith(const std::string& s, const std::string& suffix) {
 			&& s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
 }
 
-int main(int argc, char** argv) {
-
-	if (argc == 1) {
-		std::cerr << "ERROR: too few arguments." << std::endl;
-		exit(-1);
-	}
-
-	Config c;
-    std::cout<<argc;
-	for(int i = argc; i < argc; ++i) {
-		auto arg = std::string(argv[i]);
+struct Options {
+	std::vector<std::string> inputFiles;
+	bool calibrate = false;
+	int numberOfThreads = 1;
+	bool halfProbeGiven = false;
+	bool mangledGiven = false;	// XRay plans need the mangled names
+	int samplesPerSecond = 0;	// 0 if not given
+	std::string batchFile;
+	bool incremental = false;
+	std::string costRulesFile;	// per function probe costs, see CostModel.h
+	std::string traceFile;	// self profiling, see Trace.h
+	size_t syntheticNodes = 0;	// 0 if not given, see SyntheticCallgraph.h
+};
+
+/** returns false if there is an unknown or incomplete option */
+bool parseOptions(const std::vector<std::string>& args, Config& c, Options& o) {
+	for (size_t i = 0; i < args.size(); ++i) {
+		auto arg = args[i];
+
+		if (arg.empty()) {
+			std::cerr << "Empty argument" << std::endl;
+			return false;
+		}
+		if (arg.front() != '-') {
+			o.inputFiles.push_back(arg);
+			continue;
+		}
 
-		if (arg=="--other") {
-			c.otherPath = std::string(argv[++i]);
+		bool hasValue = i + 1 < args.size();
+		if ((arg=="--other" || arg=="-o") && hasValue) {
+			c.otherPath = args[++i];
 			continue;
 		}
-		if (arg=="--samples" || arg=="-s") {
-			CgConfig::samplesPerSecond = atoi(argv[++i]);
+		if ((arg=="--samples" || arg=="-s") && hasValue) {
+			o.samplesPerSecond = atoi(args[++i].c_str());
 			continue;
 		}
-		if (arg=="--ref" || arg=="-r") {
-			c.referenceRuntime = atof(argv[++i]);
+		if ((arg=="--ref" || arg=="-r") && hasValue) {
+			c.referenceRuntime = atof(args[++i].c_str());
 			continue;
 		}
 		if (arg=="--mangled" || arg=="-m") {
 			c.useMangledNames=true;
+			o.mangledGiven = true;
 			continue;
 		}
-		if (arg=="--half" || arg=="-h") {
-			c.nanosPerHalfProbe = atoi(argv[++i]);
+		if ((arg=="--half" || arg=="-h") && hasValue) {
+			c.nanosPerHalfProbe = atoi(args[++i].c_str());
+			o.halfProbeGiven = true;
 			continue;
 		}
 		if (arg=="--tiny" || arg=="-t") {
@@ -126,69 +182,327 @@ int main(int argc, char** argv) {
 			c.samplesFile = "active";	// ugly hack
 			continue;
 		}
-		if (arg=="--greedy-Unwind" || arg=="-g") {
-			c.greedyUnwind = true;
+		if ((arg=="--cost-model" || arg=="-c") && hasValue) {
+			c.costModelFile = args[++i];
+			continue;
+		}
+		if (arg=="--cost-rules" && hasValue) {
+			o.costRulesFile = args[++i];
+			continue;
+		}
+		if ((arg=="--output" || arg=="-O") && hasValue) {
+			c.outputPath = args[++i];
+			continue;
+		}
+		if (arg=="--calibrate") {
+			o.calibrate = true;
+			continue;
+		}
+		if (arg=="--synthetic" && hasValue) {
+			auto& value = args[++i];
+			char* end = nullptr;
+			o.syntheticNodes = strtoull(value.c_str(), &end, 10);
+			if (value.empty() || !isdigit((unsigned char) value[0]) || *end != '\0' || o.syntheticNodes == 0) {
+				std::cerr << "Invalid number of nodes: " << value << std::endl;
+				return false;
+			}
+			continue;
+		}
+		if ((arg=="--threads" || arg=="-j") && hasValue) {
+			o.numberOfThreads = atoi(args[++i].c_str());
+			continue;
+		}
+		if ((arg=="--budget" || arg=="-B") && hasValue) {
+			c.overheadBudgetPercent = atof(args[++i].c_str());
+			continue;
+		}
+		if ((arg=="--threshold" || arg=="-T") && hasValue) {
+			if (!RuntimeThreshold::parse(args[++i], c)) {
+				std::cerr << "Invalid threshold: " << args[i] << std::endl;
+				return false;
+			}
+			continue;
+		}
+		if (arg=="--threshold-exclusive") {
+			c.thresholdExclusive = true;
+			continue;
+		}
+		if (arg=="--ball-larus") {
+			c.ballLarus = true;
+			continue;
+		}
+		if (arg=="--callsites") {
+			c.callsites = true;
+			continue;
+		}
+		if (arg=="--cct") {
+			c.contextTree = true;
+			continue;
+		}
+		if (arg=="--optimum") {
+			c.nodeBasedOptimum = true;
+			continue;
+		}
+		if (arg=="--optimum-threads" && hasValue) {
+			c.optimumThreads = atoi(args[++i].c_str());
+			continue;
+		}
+		if (arg=="--optimum-time" && hasValue) {
+			c.optimumSeconds = atof(args[++i].c_str());
+			continue;
+		}
+		if (arg=="--optimum-steps" && hasValue) {
+			c.optimumSteps = strtoull(args[++i].c_str(), nullptr, 10);
+			continue;
+		}
+		if (arg=="--optimum-checkpoint" && hasValue) {
+			c.optimumCheckpoint = args[++i];
+			continue;
+		}
+		if (arg=="--optimum-clusters") {
+			c.optimumClusters = true;
+			continue;
+		}
+		if (arg=="--incremental") {
+			o.incremental = true;
+			continue;
+		}
+		if (arg=="--emit" && hasValue) {
+			std::istringstream formats(args[++i]);
+			std::string format;
+			while (std::getline(formats, format, ',')) {
+				if (!PlanEmitter::create(format)) {
+					std::cerr << "Unknown plan format: " << format << std::endl;
+					return false;
+				}
+				c.planFormats.push_back(format);
+			}
+			continue;
+		}
+		if (arg=="--trace" && hasValue) {
+			o.traceFile = args[++i];
+			continue;
+		}
+		if ((arg=="--batch" || arg=="-b") && hasValue) {
+			o.batchFile = args[++i];
 			continue;
 		}
 
-		std::cerr << "Unknown option: " << argv[i] << std::endl;
+		std::cerr << "Unknown option: " << arg << std::endl;
+		return false;
+	}
 
-		std::cout << "Usage: " << argv[0] << " /PATH/TO/CUBEX/PROFILE"
-				<< " [--other|-o /PATH/TO/PROFILE/TO/COMPARE/TO]"
-				<< " [--samples|-s NUMBER_OF_SAMPLES_PER_SECOND]"
-				<< " [--ref|-r UNINSTRUMENTED_RUNTIME_SECONDS]"
-				<< " [--half|-h NANOS_FOR_OVERHEAD_COMPENSATION"
-				<< " [--mangled|-m]"
-				<< " [--tiny|-t]"
-				<< std::endl << std::endl;
+	// RN: checked after all options, --mangled may follow --emit
+	if (!o.mangledGiven && std::find(c.planFormats.begin(), c.planFormats.end(), "xray") != c.planFormats.end()) {
+		std::cerr << "Plan format xray needs --mangled" << std::endl;
+		return false;
 	}
+	return true;
+}
+
+void printUsage(std::string programName) {
+	std::cout << "Usage: " << programName << " [/PATH/TO/IPCG] /PATH/TO/CUBEX/PROFILE"
+			<< " [--other|-o /PATH/TO/PROFILE/TO/COMPARE/TO]"
+			<< " [--samples|-s NUMBER_OF_SAMPLES_PER_SECOND]"
+			<< " [--ref|-r UNINSTRUMENTED_RUNTIME_SECONDS]"
+			<< " [--half|-h NANOS_FOR_OVERHEAD_COMPENSATION"
+			<< " [--mangled|-m]"
+			<< " [--tiny|-t]"
+			<< " [--cost-model|-c COST_MODEL_FILE]"
+			<< " [--cost-rules COST_RULES_FILE]"
+			<< " [--output|-O OUTPUT_DIRECTORY]"
+			<< " [--budget|-B OVERHEAD_BUDGET_PERCENT]"
+			<< " [--ball-larus]"
+			<< " [--callsites] [--cct]"
+			<< " [--optimum [--optimum-threads NUMBER_OF_THREADS] [--optimum-time SECONDS]"
+			<< " [--optimum-steps NUMBER_OF_STEPS] [--optimum-checkpoint CHECKPOINT_FILE] [--optimum-clusters]]"
+			<< " [--emit plain|scorep|gcc|xray|callsite|json[,...]]"
+			<< " [--threshold|-T percentile:P|top:K|share:P] [--threshold-exclusive]"
+			<< " [--trace TRACE_FILE]"
+			<< std::endl
+			<< "       " << programName << " --incremental /PATH/TO/IPCG /PATH/TO/CUBEX/PROFILE..."
+			<< " [OPTIONS]"
+			<< std::endl
+			<< "       " << programName << " --batch|-b MANIFEST [--threads|-j NUMBER_OF_THREADS]"
+			<< " [--output|-O OUTPUT_DIRECTORY] [OPTIONS_FOR_ALL_JOBS]"
+			<< std::endl
+			<< "       " << programName << " --calibrate [--threads|-j NUMBER_OF_THREADS]"
+			<< " [--cost-model|-c COST_MODEL_FILE]"
+			<< std::endl
+			<< "       " << programName << " --synthetic NUMBER_OF_NODES [--trace TRACE_FILE]"
+			<< std::endl << std::endl;
+}
+
+/** reads a profile into the (finalized) ipcg graph and runs the profile phases on it */
+int analyzeProfile(Config& c, CallgraphManager& cg_ipcg, std::string filePath) {
+    TRACE_ZONE("analyzeProfile", filePath);
+
+    double runTimethreshold = 0;
+    CallgraphManager cg(&c);
+
+    //for dynamic instrumentation
+    std::string fileName = filePath.substr(filePath.find_last_of('/') + 1);
+    c.appName = fileName.substr(0, fileName.find_last_of('.'));    // remove .*
+
+    if (!c.samplesFile.empty()) {
+        c.samplesFile = filePath.substr(0, filePath.find_last_of('.'))+".samples";
+        std::cout << c.samplesFile << std::endl;
+    }
+
+    if (stringEndsWith(filePath, ".cubex")) {
+
+        cg = CubeCallgraphBuilder::build_from_ipcg(filePath, &c, &cg_ipcg);
+        TRACE_ZONE("RuntimeThreshold::calculate");
+        runTimethreshold = RuntimeThreshold::calculate(cg, c);
+        //cg = CubeCallgraphBuilder::build(filePath, &c);
+    } else if (stringEndsWith(filePath, ".dot")) {
+        cg = DOTCallgraphBuilder::build(filePath, &c);
+    } /*else if (stringEndsWith(filePath, ".ipcg")){
+	    cg = IPCGAnal::build(filePath, &c);
+    }*/    else {
+        std::cerr << "ERROR: Unknown file ending in " << filePath << std::endl;
+        return EXIT_FAILURE;
+    }
+    c.totalRuntime = c.actualRuntime;
+    registerEstimatorPhases(cg, &c, 0,runTimethreshold);
 
+    cg.thatOneLargeMethod();
+    std::cout << "Total Running time by me : " << c.totalRuntime;
+    return EXIT_SUCCESS;
+}
+
+/**
+ * analyzes the ipcg (optional) with every profile.
+ * The static phases run once, every further profile only replaces the dynamic data.
+ */
+int analyze(Config& c, std::string filePath_ipcg, std::vector<std::string> filePaths,
+		BatchDriver::IPCGFileCache* cache) {
+	TRACE_ZONE("analyze", filePath_ipcg);
 
     //for static instrumentation
-    std::string filePath_ipcg(argv[1]);
     std::string ipcg_fileName = filePath_ipcg.substr(filePath_ipcg.find_last_of('/')+1);
     c.appName = ipcg_fileName.substr(0, ipcg_fileName.find_last_of('.'));
 
-    float runTimethreshold = 0;
-    CallgraphManager cg(&c);
     CallgraphManager cg_ipcg(&c);
 	if(stringEndsWith(filePath_ipcg, ".ipcg")){
-        cg_ipcg = IPCGAnal::build(ipcg_fileName, &c);
+		if (cache) {
+			cg_ipcg = IPCGAnal::build(cache->get(filePath_ipcg), &c);
+		} else {
+			cg_ipcg = IPCGAnal::build(filePath_ipcg, &c);
+		}
         registerEstimatorPhases(cg_ipcg, &c, 1,0);
 
         cg_ipcg.thatOneLargeMethod();
     }
 
+	bool incremental = filePaths.size() > 1;
+	Config staticConfig = c;
+	if (incremental) {
+		cg_ipcg.saveStaticState();
+	}
 
-    if(argc > 2) {
-        //for dynamic instrumentation
-        std::string filePath(argv[2]);
-        std::string fileName = filePath.substr(filePath.find_last_of('/') + 1);
-        c.appName = fileName.substr(0, fileName.find_last_of('.'));    // remove .*
+	int exitCode = EXIT_SUCCESS;
+	for (auto filePath : filePaths) {
+		if (incremental) {
+			cg_ipcg.restoreStaticState();
+			c = staticConfig;
+		}
+		if (analyzeProfile(c, cg_ipcg, filePath) != EXIT_SUCCESS) {
+			exitCode = EXIT_FAILURE;
+		}
+	}
+	return exitCode;
+}
 
-        if (!c.samplesFile.empty()) {
-            c.samplesFile = filePath.substr(0, filePath.find_last_of('.'))+".samples";
-            std::cout << c.samplesFile << std::endl;
-        }
+int main(int argc, char** argv) {
 
-        if (stringEndsWith(filePath, ".cubex")) {
-
-            cg = CubeCallgraphBuilder::build_from_ipcg(filePath, &c, &cg_ipcg);
-            runTimethreshold = CubeCallgraphBuilder::CalculateRuntimeThreshold(&cg);
-            //cg = CubeCallgraphBuilder::build(filePath, &c);
-        } else if (stringEndsWith(filePath, ".dot")) {
-            cg = DOTCallgraphBuilder::build(filePath, &c);
-        } /*else if (stringEndsWith(filePath, ".ipcg")){
-		    cg = IPCGAnal::build(filePath, &c);
-	    }*/    else {
-            std::cerr << "ERROR: Unknown file ending in " << filePath << std::endl;
-            exit(-1);
-        }
-        c.totalRuntime = c.actualRuntime;
-        registerEstimatorPhases(cg, &c, 0,runTimethreshold);
+	if (argc == 1) {
+		std::cerr << "ERROR: too few arguments." << std::endl;
+		exit(-1);
+	}
 
-        cg.thatOneLargeMethod();
-        std::cout << "Total Running time by me : " << c.totalRuntime;
-    }
-    return EXIT_SUCCESS;
+	Config c;
+	Options o;
+	if (!parseOptions(std::vector<std::string>(argv + 1, argv + argc), c, o)) {
+		printUsage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (o.samplesPerSecond > 0) {
+		CgConfig::samplesPerSecond = o.samplesPerSecond;
+	}
+	if (!o.traceFile.empty() && !Trace::enable(o.traceFile)) {
+		exit(1);
+	}
+
+	if (CgConfig::readCostModel(c.costModelFile)) {
+		std::cout << "Using cost model " << c.costModelFile << std::endl;
+		if (!o.halfProbeGiven) {
+			c.nanosPerHalfProbe = CgConfig::nanosPerHalfProbe;
+		}
+	}
+
+	if (!o.costRulesFile.empty()) {
+		auto costModel = std::make_shared<RuleBasedCostModel>();
+		if (!costModel->readRules(o.costRulesFile)) {
+			std::cerr << "Error: can not read cost rules " << o.costRulesFile << std::endl;
+			exit(1);
+		}
+		CgConfig::setCostModel(costModel);
+		std::cout << "Using cost rules " << o.costRulesFile << std::endl;
+	}
+
+	if (o.calibrate) {
+		return Calibration::run(o.numberOfThreads, c.costModelFile);
+	}
+	if (o.syntheticNodes > 0) {
+		return SyntheticCallgraph::run(o.syntheticNodes);
+	}
+
+	if (!o.batchFile.empty()) {
+		// RN: the cost model, cost rules & samples per second are global, so they can only be set for all jobs
+		auto parseJobOptions = [&o](const std::vector<std::string>& args, Config& jobConfig) {
+			Options jobOptions;
+			jobOptions.mangledGiven = o.mangledGiven;	// the job config starts with the global options
+			if (!parseOptions(args, jobConfig, jobOptions)) {
+				return false;
+			}
+			if (!jobOptions.inputFiles.empty() || !jobOptions.batchFile.empty() || jobOptions.calibrate
+					|| jobOptions.syntheticNodes > 0 || jobOptions.samplesPerSecond > 0 || jobOptions.incremental
+					|| !jobOptions.traceFile.empty()) {
+				std::cerr << "Input files, --batch, --calibrate, --synthetic, --incremental, --samples & --trace"
+						<< " can not be given per job"
+						<< std::endl;
+				return false;
+			}
+			return true;
+		};
+		auto analyzeJob = [](BatchDriver::Job& job, BatchDriver::IPCGFileCache& cache) {
+			std::vector<std::string> profiles;
+			if (!job.profileFile.empty()) {
+				profiles.push_back(job.profileFile);
+			}
+			return analyze(job.config, job.ipcgFile, profiles, &cache);
+		};
+
+		auto jobs = BatchDriver::readManifest(o.batchFile, c, parseJobOptions);
+		return BatchDriver::run(jobs, c, o.numberOfThreads, analyzeJob);
+	}
+
+	if (o.inputFiles.empty()) {
+		std::cerr << "ERROR: no input file given." << std::endl;
+		exit(-1);
+	}
+
+	if (!BatchDriver::createDirectory(c.outputPath)) {
+		return EXIT_FAILURE;
+	}
+	if (o.inputFiles.size() == 1 && !stringEndsWith(o.inputFiles[0], ".ipcg")) {
+		return analyze(c, "", o.inputFiles, nullptr);	// profile only, as in spec-run.sh
+	}
+	std::vector<std::string> profiles(o.inputFiles.begin() + 1, o.inputFiles.end());
+	if (!o.incremental && profiles.size() > 1) {
+		std::cerr << "More than one profile given, use --incremental to analyze all of them" << std::endl;
+		profiles.resize(1);
+	}
+	return analyze(c, o.inputFiles[0], profiles, nullptr);
 }
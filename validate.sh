@@ -0,0 +1,146 @@
+#!/bin/bash
+
+# Compares the instrumentation overhead every phase predicts (instrOvSeconds in the summary) with the
+# overhead measured with the plan of the phase. Every testcase with a profile is built uninstrumented and
+# with -finstrument-functions against the plan runtime (make runtime), then run with each plain plan.
+# The measured overhead is relative to the instrumented build without a plan, so the probes of the
+# filtered functions and the startup of the runtime are not part of it.
+# The result is in $V_OUT/validation.tsv, one line per testcase and phase, the relative error per phase
+# is printed at the end.
+#
+# RN: the testcases run for milliseconds, so the measured seconds are mostly noise there. The measured
+# calls come from the runtime and have to match the predicted calls exactly.
+# The plans have the demangled names of the profile, the runtime finds them in the symbol table. A plan
+# entry the runtime can not find makes the validation fail, the plan would only be measured in part.
+
+CCG=${CCG:-./CubeCallGraphTool}
+RUNTIME=runtime/PlanRuntime.o
+# testcases, NAME.cpp next to NAME.cubex
+V_IN=${V_IN:-testcases}
+# output is dumped here
+V_OUT=${V_OUT:-validate-output}
+# runs per measurement, the fastest one counts
+RUNS=${RUNS:-20}
+CXX=${CXX:-g++}
+V_CXXFLAGS="-O2"
+
+if [ ! -x $CCG ] || [ ! -f $RUNTIME ]; then
+	echo "$CCG or $RUNTIME missing, run make validate"
+	exit 1
+fi
+
+rm -rf $V_OUT
+mkdir $V_OUT
+
+# seconds of the fastest of $RUNS runs of "$@"
+measure() {
+	local best=""
+	for ((run = 0; run < RUNS; run++)); do
+		local start=$(date +%s%N)
+		"$@" > /dev/null 2>&1
+		local end=$(date +%s%N)
+		if [ -z "$best" ] || [ $((end - start)) -lt $best ]; then
+			best=$((end - start))
+		fi
+	done
+	awk -v nanos=$best 'BEGIN { printf "%.9f", nanos / 1e9 }'
+}
+
+TSV=$V_OUT/validation.tsv
+echo -e "testcase\tphase\tplanEntries\tunresolved\tpredictedCalls\tmeasuredCalls\tpredictedSeconds\tmeasuredSeconds\trelativeError" > $TSV
+
+for profile in $V_IN/*.cubex; do
+	NAME=$(basename $profile .cubex)
+	SOURCE=$V_IN/$NAME.cpp
+	if [ ! -f $SOURCE ]; then
+		echo "skipping $NAME, no $SOURCE"
+		continue
+	fi
+	OUT=$V_OUT/$NAME
+	mkdir $OUT
+
+	if ! $CXX $V_CXXFLAGS -o $OUT/$NAME $SOURCE \
+			|| ! $CXX $V_CXXFLAGS -finstrument-functions -rdynamic -o $OUT/$NAME-instrumented $SOURCE $RUNTIME -ldl; then
+		echo "skipping $NAME, build failed"
+		continue
+	fi
+
+	UNINSTRUMENTED=$(measure $OUT/$NAME)
+	BASELINE=$(measure $OUT/$NAME-instrumented)
+	echo "running $NAME (uninstrumented $UNINSTRUMENTED s, instrumented without a plan $BASELINE s)"
+
+	if ! $CCG $profile --tiny --emit plain --output $OUT --ref $UNINSTRUMENTED &> $OUT/$NAME.log; then
+		echo "skipping $NAME, analysis failed (see $OUT/$NAME.log)"
+		continue
+	fi
+
+	tail -n +2 $OUT/summary-$NAME.tsv | while IFS=$'\t' read PHASE METHODS CALLS INSTR_SECONDS REST; do
+		PLAN=$OUT/plan-$NAME-$PHASE.txt
+		if [ ! -f $PLAN ]; then
+			continue
+		fi
+		PROFILE=$OUT/profile-$NAME-$PHASE.txt
+
+		# the runtime lists every plan entry it can not find, the rest is measured anyway to see the calls
+		ENTRIES=$(grep -cv '^\(#\|$\)' $PLAN)
+		PGOE_ALLOW_UNRESOLVED=1 PGOE_PLAN=$PLAN PGOE_OUTPUT=$PROFILE $OUT/$NAME-instrumented \
+				> /dev/null 2> $OUT/runtime-$NAME-$PHASE.log
+		UNRESOLVED=$(grep -c ' not found$' $OUT/runtime-$NAME-$PHASE.log)
+		if [ $UNRESOLVED -gt 0 ]; then
+			UNRESOLVED=$((UNRESOLVED - 1))	# without the summary line
+			echo "$NAME $PHASE: $UNRESOLVED of $ENTRIES plan entries not found (see $OUT/runtime-$NAME-$PHASE.log)"
+		fi
+
+		SECONDS_WITH_PLAN=$(PGOE_ALLOW_UNRESOLVED=1 PGOE_PLAN=$PLAN PGOE_OUTPUT=$PROFILE measure $OUT/$NAME-instrumented)
+		# an empty plan writes no profile
+		MEASURED_CALLS=0
+		if [ -f $PROFILE ]; then
+			MEASURED_CALLS=$(awk -F'\t' '{ calls += $2 } END { print calls + 0 }' $PROFILE)
+		fi
+
+		awk -v name=$NAME -v phase=$PHASE -v entries=$ENTRIES -v unresolved=$UNRESOLVED \
+				-v calls=$CALLS -v measuredCalls=$MEASURED_CALLS \
+				-v predicted=$INSTR_SECONDS -v base=$BASELINE -v withPlan=$SECONDS_WITH_PLAN 'BEGIN {
+			measured = withPlan - base
+			error = (predicted > 0) ? sprintf("%.3f", (measured - predicted) / predicted) : "-"
+			printf "%s\t%s\t%d\t%d\t%d\t%d\t%.9f\t%.9f\t%s\n", name, phase, entries, unresolved,
+					calls, measuredCalls, predicted, measured, error
+		}' >> $TSV
+	done
+done
+
+echo
+echo "relative error of the predicted instrumentation overhead per phase (details in $TSV)"
+tail -n +2 $TSV | awk -F'\t' '
+{
+	if (!($2 in cases)) {
+		phases[++numberOfPhases] = $2
+	}
+	cases[$2]++
+	entries[$2] += $3
+	unresolved[$2] += $4
+	if ($5 != $6) {
+		callMismatches[$2]++
+	}
+	if ($9 != "-") {
+		errors[$2] += ($9 < 0) ? -$9 : $9
+		numberOfErrors[$2]++
+	}
+}
+END {
+	printf "%-28s %8s %12s %16s %16s\n", "phase", "cases", "unresolved", "call mismatches", "mean |error|"
+	for (i = 1; i <= numberOfPhases; i++) {
+		phase = phases[i]
+		meanError = (numberOfErrors[phase] > 0) ? sprintf("%.3f", errors[phase] / numberOfErrors[phase]) : "-"
+		share = (entries[phase] > 0) ? sprintf("%.1f%%", 100 * unresolved[phase] / entries[phase]) : "-"
+		printf "%-28s %8d %12s %16d %16s\n", phase, cases[phase], share, callMismatches[phase], meanError
+	}
+}'
+
+# the measured calls of a plan that is only partly resolved say nothing about the prediction
+UNRESOLVED_TOTAL=$(tail -n +2 $TSV | awk -F'\t' '{ unresolved += $4 } END { print unresolved + 0 }')
+if [ $UNRESOLVED_TOTAL -gt 0 ]; then
+	echo
+	echo "FAILED: $UNRESOLVED_TOTAL plan entries could not be resolved by the runtime"
+	exit 1
+fi